@@ -1,6 +1,7 @@
 #include "b3.h"
 #include "descriptor.h"
 #include "test_structure.h"
+#include "wigner3j.h"
 #include "gtest/gtest.h"
 #include <Eigen/Dense>
 #include <cmath>
@@ -280,3 +281,305 @@ TYPED_TEST(DescTest, RotationTest) {
 //     }
 //   }
 // }
+
+TEST(B2Test, MatchesReference) {
+  // The vectorized B2 kernel should reproduce the scalar loop exactly. The
+  // structure is built without rand() so that the random draws of the
+  // other tests are unchanged.
+  int n_atoms = 12, n_species = 2, N = 4, L = 3;
+  double cutoff = 4;
+  std::vector<double> radial_hyps{0, cutoff}, cutoff_hyps;
+  std::vector<int> descriptor_settings{n_species, N, L};
+  B2 ps("chebyshev", "cosine", radial_hyps, cutoff_hyps, descriptor_settings);
+
+  Eigen::MatrixXd cell = Eigen::MatrixXd::Identity(3, 3) * 6;
+  Eigen::MatrixXd positions(n_atoms, 3);
+  std::vector<int> species;
+  for (int i = 0; i < n_atoms; i++) {
+    positions.row(i) << fmod(1.7 * i, 6), fmod(2.3 * i + 0.4, 6),
+        fmod(3.1 * i + 0.9, 6);
+    species.push_back(i % n_species);
+  }
+  Structure test_struc(cell, species, positions, cutoff, {});
+
+  Eigen::MatrixXd single_bond_vals, force_dervs, neighbor_coords;
+  Eigen::VectorXi neighbor_count, cumulative_neighbor_count,
+      descriptor_indices;
+  single_bond_multiple_cutoffs(
+      single_bond_vals, force_dervs, neighbor_coords, neighbor_count,
+      cumulative_neighbor_count, descriptor_indices, ps.radial_pointer,
+      ps.cutoff_pointer, n_species, N, L, radial_hyps, cutoff_hyps,
+      test_struc, ps.cutoffs);
+
+  Eigen::MatrixXd B2_vals, B2_force_dervs;
+  Eigen::VectorXd B2_norms, B2_force_dots;
+  compute_b2(B2_vals, B2_force_dervs, B2_norms, B2_force_dots,
+             single_bond_vals, force_dervs, neighbor_count,
+             cumulative_neighbor_count, descriptor_indices, n_species, N, L);
+
+  int n_radial = n_species * N;
+  int n_harmonics = (L + 1) * (L + 1);
+  Eigen::MatrixXd ref_vals = Eigen::MatrixXd::Zero(B2_vals.rows(),
+                                                   B2_vals.cols());
+  Eigen::MatrixXd ref_dervs = Eigen::MatrixXd::Zero(B2_force_dervs.rows(),
+                                                    B2_force_dervs.cols());
+  for (int atom = 0; atom < n_atoms; atom++) {
+    int force_start = cumulative_neighbor_count(atom) * 3;
+    int counter = 0;
+    for (int n1 = 0; n1 < n_radial; n1++) {
+      for (int n2 = n1; n2 < n_radial; n2++) {
+        for (int l = 0; l < L + 1; l++) {
+          for (int m = 0; m < 2 * l + 1; m++) {
+            int n1_l = n1 * n_harmonics + (l * l + m);
+            int n2_l = n2 * n_harmonics + (l * l + m);
+            ref_vals(atom, counter) +=
+                single_bond_vals(atom, n1_l) * single_bond_vals(atom, n2_l);
+            for (int ind = force_start;
+                 ind < force_start + 3 * neighbor_count(atom); ind++) {
+              ref_dervs(ind, counter) +=
+                  single_bond_vals(atom, n1_l) * force_dervs(ind, n2_l) +
+                  force_dervs(ind, n1_l) * single_bond_vals(atom, n2_l);
+            }
+          }
+          counter++;
+        }
+      }
+    }
+  }
+
+  EXPECT_EQ(B2_vals, ref_vals);
+  EXPECT_EQ(B2_force_dervs, ref_dervs);
+}
+
+TEST(B2Test, TableForces) {
+  // B2 descriptors computed with the tabulated radial basis should be close
+  // to those computed with the exact basis, and their force derivatives
+  // should match finite differences of the descriptors. The structure is
+  // built without rand() so that the random draws of the other tests are
+  // unchanged.
+  int n_atoms = 8, n_species = 2, N = 4, L = 3;
+  double cutoff = 4;
+  std::vector<double> radial_hyps{0, cutoff}, cutoff_hyps;
+  std::vector<int> descriptor_settings{n_species, N, L};
+  B2 ps("chebyshev", "cosine", radial_hyps, cutoff_hyps, descriptor_settings);
+  std::vector<Descriptor *> dc{&ps};
+
+  Eigen::MatrixXd cell = Eigen::MatrixXd::Identity(3, 3) * 6;
+  Eigen::MatrixXd positions(n_atoms, 3);
+  std::vector<int> species;
+  for (int i = 0; i < n_atoms; i++) {
+    positions.row(i) << fmod(1.7 * i, 6), fmod(2.3 * i + 0.4, 6),
+        fmod(3.1 * i + 0.9, 6);
+    species.push_back(i % n_species);
+  }
+  Structure test_struc(cell, species, positions, cutoff, dc);
+
+  // Single bond values with and without the tables.
+  Eigen::MatrixXd exact_vals, exact_dervs, table_vals, table_dervs,
+      neighbor_coords;
+  Eigen::VectorXi neighbor_count, cumulative_neighbor_count,
+      descriptor_indices;
+  single_bond_multiple_cutoffs(
+      exact_vals, exact_dervs, neighbor_coords, neighbor_count,
+      cumulative_neighbor_count, descriptor_indices, ps.radial_pointer,
+      ps.cutoff_pointer, n_species, N, L, radial_hyps, cutoff_hyps,
+      test_struc, ps.cutoffs);
+  single_bond_multiple_cutoffs(
+      table_vals, table_dervs, neighbor_coords, neighbor_count,
+      cumulative_neighbor_count, descriptor_indices, ps.radial_pointer,
+      ps.cutoff_pointer, n_species, N, L, radial_hyps, cutoff_hyps,
+      test_struc, ps.cutoffs, ps.radial_tables);
+  EXPECT_LT((table_vals - exact_vals).cwiseAbs().maxCoeff(), 1e-8);
+  EXPECT_LT((table_dervs - exact_dervs).cwiseAbs().maxCoeff(), 1e-6);
+
+  // Finite differences of E = sum_i w . d_i, where d_i is the descriptor of
+  // atom i and w is a fixed weight vector.
+  const DescriptorValues &desc = test_struc.descriptors[0];
+  Eigen::VectorXd weights(desc.n_descriptors);
+  for (int k = 0; k < desc.n_descriptors; k++)
+    weights(k) = sin(0.7 * k + 0.3);
+
+  auto energy = [&](const Structure &struc) {
+    double e = 0;
+    for (int s = 0; s < struc.descriptors[0].n_types; s++)
+      e += (struc.descriptors[0].descriptors[s] * weights).sum();
+    return e;
+  };
+
+  Eigen::MatrixXd gradient = Eigen::MatrixXd::Zero(n_atoms, 3);
+  for (int s = 0; s < desc.n_types; s++) {
+    Eigen::VectorXd derv_dots = desc.descriptor_force_dervs[s] * weights;
+    for (int j = 0; j < desc.n_clusters_by_type[s]; j++) {
+      // Moving a neighbor changes its bond to the central atom, and moving
+      // the central atom changes all of its bonds.
+      int n_neigh = desc.neighbor_counts[s](j);
+      int c_neigh = desc.cumulative_neighbor_counts[s](j);
+      int atom_index = desc.atom_indices[s](j);
+      for (int k = 0; k < n_neigh; k++) {
+        int neighbor_index = desc.neighbor_indices[s](c_neigh + k);
+        for (int comp = 0; comp < 3; comp++) {
+          double derv = derv_dots(3 * (c_neigh + k) + comp);
+          gradient(neighbor_index, comp) += derv;
+          gradient(atom_index, comp) -= derv;
+        }
+      }
+    }
+  }
+
+  double delta = 1e-5;
+  for (int atom = 0; atom < n_atoms; atom++) {
+    for (int comp = 0; comp < 3; comp++) {
+      Eigen::MatrixXd positions_up = positions, positions_down = positions;
+      positions_up(atom, comp) += delta;
+      positions_down(atom, comp) -= delta;
+      Structure struc_up(cell, species, positions_up, cutoff, dc);
+      Structure struc_down(cell, species, positions_down, cutoff, dc);
+      double fin_diff = (energy(struc_up) - energy(struc_down)) / (2 * delta);
+      EXPECT_NEAR(gradient(atom, comp), fin_diff, 1e-6);
+    }
+  }
+}
+
+TEST(B3Test, MatchesReference) {
+  // The sparse Wigner 3j contraction should reproduce the dense loop over
+  // all (m1, m2, m3) triples, for both complex and real harmonics.
+  int n_atoms = 8, n_species = 2, N = 2, L = 2;
+  double cutoff = 4;
+  std::vector<double> radial_hyps{0, cutoff}, cutoff_hyps;
+  std::vector<int> descriptor_settings{n_species, N, L};
+  B3 ps("chebyshev", "cosine", radial_hyps, cutoff_hyps, descriptor_settings);
+
+  Eigen::MatrixXd cell = Eigen::MatrixXd::Identity(3, 3) * 6;
+  Eigen::MatrixXd positions(n_atoms, 3);
+  std::vector<int> species;
+  for (int i = 0; i < n_atoms; i++) {
+    positions.row(i) << fmod(1.7 * i, 6), fmod(2.3 * i + 0.4, 6),
+        fmod(3.1 * i + 0.9, 6);
+    species.push_back(i % n_species);
+  }
+  Structure test_struc(cell, species, positions, cutoff, {});
+
+  Eigen::MatrixXcd single_bond_vals, force_dervs;
+  Eigen::MatrixXd neighbor_coords;
+  Eigen::VectorXi neighbor_count, cumulative_neighbor_count,
+      descriptor_indices;
+  complex_single_bond(single_bond_vals, force_dervs, neighbor_coords,
+                      neighbor_count, cumulative_neighbor_count,
+                      descriptor_indices, ps.radial_pointer, ps.cutoff_pointer,
+                      n_species, N, L, radial_hyps, cutoff_hyps, test_struc);
+
+  Eigen::MatrixXd B3_vals, B3_force_dervs;
+  Eigen::VectorXd B3_norms, B3_force_dots;
+  compute_B3(B3_vals, B3_force_dervs, B3_norms, B3_force_dots,
+             single_bond_vals, force_dervs, neighbor_count,
+             cumulative_neighbor_count, descriptor_indices, n_species, N, L,
+             *get_wigner3j_terms(L));
+
+  Eigen::MatrixXd real_vals, real_dervs, real_coords;
+  Eigen::VectorXi real_count, real_cumulative_count, real_indices;
+  compute_single_bond(real_vals, real_dervs, real_coords, real_count,
+                      real_cumulative_count, real_indices, ps.radial_pointer,
+                      ps.cutoff_pointer, n_species, N, L, radial_hyps,
+                      cutoff_hyps, test_struc);
+  Eigen::MatrixXd B3_real_vals, B3_real_force_dervs;
+  Eigen::VectorXd B3_real_norms, B3_real_force_dots;
+  compute_B3(B3_real_vals, B3_real_force_dervs, B3_real_norms,
+             B3_real_force_dots, real_vals, real_dervs, real_count,
+             real_cumulative_count, real_indices, n_species, N, L,
+             *ps.wigner3j_terms);
+
+  Eigen::VectorXd coeffs = compute_coeffs(L);
+  int n_radial = n_species * N;
+  int n_harmonics = (L + 1) * (L + 1);
+  Eigen::MatrixXd ref_vals = Eigen::MatrixXd::Zero(B3_vals.rows(),
+                                                   B3_vals.cols());
+  Eigen::MatrixXd ref_dervs = Eigen::MatrixXd::Zero(B3_force_dervs.rows(),
+                                                    B3_force_dervs.cols());
+  for (int atom = 0; atom < n_atoms; atom++) {
+    int force_start = cumulative_neighbor_count(atom) * 3;
+    int counter = 0;
+    for (int n1 = 0; n1 < n_radial; n1++) {
+      for (int n2 = n1; n2 < n_radial; n2++) {
+        for (int n3 = n2; n3 < n_radial; n3++) {
+          int m_index = 0;
+          for (int l1 = 0; l1 < L + 1; l1++) {
+            for (int l2 = 0; l2 < L + 1; l2++) {
+              for (int l3 = 0; l3 < L + 1; l3++) {
+                bool allowed = (abs(l1 - l2) <= l3) && (l3 <= l1 + l2);
+                for (int m1 = 0; m1 < 2 * l1 + 1; m1++) {
+                  for (int m2 = 0; m2 < 2 * l2 + 1; m2++) {
+                    for (int m3 = 0; m3 < 2 * l3 + 1; m3++) {
+                      if (!allowed) {
+                        m_index++;
+                        continue;
+                      }
+                      std::complex<double> c = coeffs(m_index++);
+                      int i1 = n1 * n_harmonics + l1 * l1 + m1;
+                      int i2 = n2 * n_harmonics + l2 * l2 + m2;
+                      int i3 = n3 * n_harmonics + l3 * l3 + m3;
+                      std::complex<double> v1 = single_bond_vals(atom, i1);
+                      std::complex<double> v2 = single_bond_vals(atom, i2);
+                      std::complex<double> v3 = single_bond_vals(atom, i3);
+                      ref_vals(atom, counter) += real(c * v1 * v2 * v3);
+                      for (int ind = force_start;
+                           ind < force_start + 3 * neighbor_count(atom);
+                           ind++) {
+                        ref_dervs(ind, counter) +=
+                            real(c * (force_dervs(ind, i1) * v2 * v3 +
+                                      v1 * force_dervs(ind, i2) * v3 +
+                                      v1 * v2 * force_dervs(ind, i3)));
+                      }
+                    }
+                  }
+                }
+                if (allowed)
+                  counter++;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  EXPECT_EQ(B3_vals.cols(), ref_vals.cols());
+  double scale = ref_vals.cwiseAbs().maxCoeff();
+  EXPECT_NEAR((B3_vals - ref_vals).cwiseAbs().maxCoeff(), 0, 1e-12 * scale);
+  EXPECT_NEAR((B3_real_vals - ref_vals).cwiseAbs().maxCoeff(), 0,
+              1e-12 * scale);
+  scale = ref_dervs.cwiseAbs().maxCoeff();
+  EXPECT_NEAR((B3_force_dervs - ref_dervs).cwiseAbs().maxCoeff(), 0,
+              1e-12 * scale);
+  EXPECT_NEAR((B3_real_force_dervs - ref_dervs).cwiseAbs().maxCoeff(), 0,
+              1e-12 * scale);
+}
+
+TEST(Wigner3jTest, Orthogonality) {
+  // (2 l3 + 1) sum_{m1, m2} (l1 l2 l3; m1 m2 m3)^2 = 1 for allowed triples.
+  int lmax = 10;
+  for (int l1 = 0; l1 < lmax + 1; l1++) {
+    for (int l2 = 0; l2 < lmax + 1; l2++) {
+      for (int l3 = abs(l1 - l2); l3 < std::min(lmax, l1 + l2) + 1; l3++) {
+        for (int m3 = -l3; m3 < l3 + 1; m3++) {
+          double sum = 0;
+          for (int m1 = -l1; m1 < l1 + 1; m1++) {
+            double w = wigner3j(l1, l2, l3, m1, -m1 - m3, m3);
+            sum += w * w;
+          }
+          EXPECT_NEAR((2 * l3 + 1) * sum, 1, 1e-12);
+        }
+      }
+    }
+  }
+
+  // Closed forms for l1 = 0 and for odd l1 + l2 + l3 with m = 0.
+  EXPECT_NEAR(wigner3j(0, 4, 4, 0, -1, 1), -1. / 3, 1e-15);
+  EXPECT_NEAR(wigner3j(1, 1, 2, 1, -1, 0), sqrt(1. / 30), 1e-15);
+  EXPECT_EQ(wigner3j(3, 3, 3, 0, 0, 0), 0);
+
+  // Descriptors with the same lmax share one table.
+  std::vector<double> radial_hyps{0, 4}, cutoff_hyps;
+  B3 desc1("chebyshev", "cosine", radial_hyps, cutoff_hyps, {1, 2, 6});
+  B3 desc2("chebyshev", "cosine", radial_hyps, cutoff_hyps, {2, 3, 6});
+  EXPECT_EQ(desc1.wigner3j_terms, desc2.wigner3j_terms);
+}
@@ -1,8 +1,13 @@
 #include <nlohmann/json.hpp>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include "gtest/gtest.h"
 #include <Eigen/Dense>
 #include "json.h"
+#include "binary.h"
+#include "sparse_gp.h"
+#include "test_structure.h"
 
 TEST(JsonTest, MatTest){
   Eigen::MatrixXd test = Eigen::MatrixXd::Random(3, 3);
@@ -30,3 +35,208 @@ TEST(JsonTest, SizeTest){
   std::cout << j[1] << std::endl;
 }
 
+TEST(JsonTest, BinaryMatTest){
+  Eigen::MatrixXd test = Eigen::MatrixXd::Random(5, 3);
+  Eigen::VectorXi test_int = Eigen::VectorXi::Random(7);
+  std::vector<Eigen::MatrixXd> test_vec{test, Eigen::MatrixXd()};
+
+  flare_binary::write_binary("mat.bin", test_vec);
+  flare_binary::ArrayReader reader("mat.bin");
+  EXPECT_EQ(reader.n_arrays(), 2);
+
+  // Arrays are aligned and can be viewed in place.
+  Eigen::Map<const Eigen::MatrixXd> view =
+      reader.matrix(reader.metadata[0]["$array"]);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(view.data()) %
+                flare_binary::array_alignment, 0);
+  EXPECT_EQ(view, test);
+
+  flare_binary::write_binary("vec.bin", test_int);
+  flare_binary::ArrayReader int_reader("vec.bin");
+  Eigen::VectorXi test_int_2 = int_reader.metadata;
+  EXPECT_EQ(test_int, test_int_2);
+
+  // References cannot be resolved without the reader that owns the arrays.
+  nlohmann::json reference = nlohmann::json::parse("{\"$array\": 0}");
+  EXPECT_THROW(Eigen::VectorXi unresolved = reference, std::runtime_error);
+}
+
+TEST(JsonTest, BinaryCorruptTest){
+  // Corrupt headers and tables of contents are rejected when the file is
+  // opened, before any array is read.
+  Eigen::MatrixXd test = Eigen::MatrixXd::Random(5, 3);
+  flare_binary::write_binary("mat.bin", test);
+
+  std::ifstream file("mat.bin", std::ios::binary);
+  std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+  file.close();
+
+  flare_binary::FileHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  flare_binary::ArrayEntry entry;
+  std::memcpy(&entry, bytes.data() + header.toc_offset, sizeof(entry));
+
+  auto write_corrupt = [&](const flare_binary::FileHeader &bad_header,
+                           const flare_binary::ArrayEntry &bad_entry) {
+    std::vector<char> bad_bytes = bytes;
+    std::memcpy(bad_bytes.data(), &bad_header, sizeof(bad_header));
+    std::memcpy(bad_bytes.data() + header.toc_offset, &bad_entry,
+                sizeof(bad_entry));
+    std::ofstream bad_file("mat.bin", std::ios::binary);
+    bad_file.write(bad_bytes.data(), bad_bytes.size());
+  };
+
+  flare_binary::FileHeader bad_header = header;
+  bad_header.toc_offset = header.file_size;
+  write_corrupt(bad_header, entry);
+  EXPECT_THROW(flare_binary::ArrayReader reader("mat.bin"), std::runtime_error);
+
+  bad_header = header;
+  bad_header.n_arrays = 1 << 30;
+  write_corrupt(bad_header, entry);
+  EXPECT_THROW(flare_binary::ArrayReader reader("mat.bin"), std::runtime_error);
+
+  bad_header = header;
+  bad_header.metadata_size = header.file_size;
+  write_corrupt(bad_header, entry);
+  EXPECT_THROW(flare_binary::ArrayReader reader("mat.bin"), std::runtime_error);
+
+  flare_binary::ArrayEntry bad_entry = entry;
+  bad_entry.rows = header.file_size;
+  write_corrupt(header, bad_entry);
+  EXPECT_THROW(flare_binary::ArrayReader reader("mat.bin"), std::runtime_error);
+
+  bad_entry = entry;
+  bad_entry.rows = int64_t(1) << 62;
+  bad_entry.cols = 4;
+  write_corrupt(header, bad_entry);
+  EXPECT_THROW(flare_binary::ArrayReader reader("mat.bin"), std::runtime_error);
+
+  bad_entry = entry;
+  bad_entry.offset = entry.offset + 1;
+  write_corrupt(header, bad_entry);
+  EXPECT_THROW(flare_binary::ArrayReader reader("mat.bin"), std::runtime_error);
+
+  write_corrupt(header, entry);
+  flare_binary::ArrayReader reader("mat.bin");
+  Eigen::MatrixXd test_2 = reader.metadata;
+  EXPECT_EQ(test, test_2);
+}
+
+TEST_F(StructureTest, BinarySparseGP){
+  // Check that the binary format reproduces the JSON round trip.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels;
+  kernels.push_back(&kernel_norm);
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  std::vector<Descriptor *> b2_calculators{&ps};
+  Structure struc_1(cell, species, positions, cutoff, b2_calculators);
+  struc_1.energy = Eigen::VectorXd::Random(1);
+  struc_1.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  struc_1.stresses = Eigen::VectorXd::Random(6);
+
+  sparse_gp.add_training_structure(struc_1);
+  sparse_gp.add_all_environments(struc_1);
+  sparse_gp.update_matrices_QR();
+  sparse_gp.compute_likelihood_stable();
+  sparse_gp.trace_term = 0;
+
+  SparseGP::to_json("sgp.json", sparse_gp);
+  SparseGP::to_binary("sgp.bin", sparse_gp);
+  SparseGP sgp_json = SparseGP::from_json("sgp.json");
+  SparseGP sgp_bin = SparseGP::from_binary("sgp.bin");
+
+  nlohmann::json j_json = sgp_json;
+  nlohmann::json j_bin = sgp_bin;
+  EXPECT_EQ(j_json, j_bin);
+
+  // A prediction-only model gives the same predictions, with the solution
+  // matrices read from the mapped file.
+  SparseGP sgp_predict = SparseGP::from_binary("sgp.bin", true);
+  EXPECT_EQ(sgp_predict.training_structures.size(), 0);
+  EXPECT_EQ(sgp_predict.Kuf.size(), 0);
+  EXPECT_EQ(sgp_predict.mapped_arrays.size(), 4);
+  EXPECT_EQ(sgp_predict.Sigma.size(), 0);
+  EXPECT_EQ(sgp_predict.solution_matrix("Sigma"), sparse_gp.Sigma);
+
+  sparse_gp.predict_SOR(test_struc_2);
+  Structure struc_2 = test_struc_2;
+  sgp_predict.predict_SOR(struc_2);
+  EXPECT_EQ(test_struc_2.mean_efs, struc_2.mean_efs);
+  EXPECT_EQ(test_struc_2.variance_efs, struc_2.variance_efs);
+
+  sparse_gp.predict_DTC(test_struc_2);
+  sgp_predict.predict_DTC(struc_2);
+  EXPECT_EQ(test_struc_2.mean_efs, struc_2.mean_efs);
+  EXPECT_EQ(test_struc_2.variance_efs, struc_2.variance_efs);
+
+  // Coefficient files only depend on what a prediction-only model keeps.
+  auto file_body = [](const std::string &file_name) {
+    std::ifstream file(file_name);
+    std::string date_line;
+    std::getline(file, date_line);
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  };
+  sparse_gp.write_mapping_coefficients("beta.txt", "A", 0);
+  std::string beta = file_body("beta.txt");
+  sgp_predict.write_mapping_coefficients("beta.txt", "A", 0);
+  EXPECT_EQ(file_body("beta.txt"), beta);
+
+  sparse_gp.write_varmap_coefficients("beta_var.txt", "A", 0);
+  std::string beta_var = file_body("beta_var.txt");
+  sgp_predict.write_varmap_coefficients("beta_var.txt", "A", 0);
+  EXPECT_EQ(file_body("beta_var.txt"), beta_var);
+
+  sparse_gp.write_L_inverse("L_inv.txt", "A");
+  std::string L_inv = file_body("L_inv.txt");
+  sgp_predict.write_L_inverse("L_inv.txt", "A");
+  EXPECT_EQ(file_body("L_inv.txt"), L_inv);
+
+  // Saving a mapped model, even over its own file, writes the mapped
+  // matrices.
+  SparseGP::to_binary("sgp.bin", sgp_predict);
+  SparseGP sgp_resaved = SparseGP::from_binary("sgp.bin");
+  EXPECT_EQ(sgp_resaved.Sigma, sparse_gp.Sigma);
+  EXPECT_EQ(sgp_resaved.L_inv, sparse_gp.L_inv);
+}
+
+TEST_F(StructureTest, LegacySparseGP){
+  // Model files written before compact training was added lack the
+  // compact_training and force_dervs_basis keys, and should still load.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels;
+  kernels.push_back(&kernel_norm);
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  std::vector<Descriptor *> b2_calculators{&ps};
+  Structure struc_1(cell, species, positions, cutoff, b2_calculators);
+  struc_1.energy = Eigen::VectorXd::Random(1);
+  struc_1.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  sparse_gp.add_training_structure(struc_1);
+  sparse_gp.add_all_environments(struc_1);
+  sparse_gp.update_matrices_QR();
+
+  nlohmann::json j = sparse_gp;
+  j.erase("compact_training");
+  for (auto &struc : j["training_structures"]) {
+    for (auto &desc : struc["descriptors"]) {
+      desc.erase("force_dervs_basis");
+    }
+  }
+
+  SparseGP sgp_legacy = j;
+  EXPECT_FALSE(sgp_legacy.compact_training);
+  EXPECT_FALSE(
+      sgp_legacy.training_structures[0].descriptors[0].compressed());
+  EXPECT_EQ(sgp_legacy.alpha, sparse_gp.alpha);
+  EXPECT_EQ(sgp_legacy.Kuf, sparse_gp.Kuf);
+}
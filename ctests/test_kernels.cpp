@@ -74,6 +74,22 @@ TYPED_TEST(KernelTest, TestEnvsStruc) {
   }
 }
 
+TYPED_TEST(KernelTest, TestSelfKernelEnvs) {
+  TypeParam kernel(this->hyp0, this->hyp1);
+
+  ClusterDescriptor envs;
+  envs.add_all_clusters(this->struc_desc);
+  Eigen::MatrixXd kern_mat =
+      kernel.envs_envs(envs, envs, kernel.kernel_hyperparameters);
+  Eigen::VectorXd self_kern =
+      kernel.self_kernel_envs(envs, kernel.kernel_hyperparameters);
+
+  EXPECT_EQ(self_kern.size(), envs.n_clusters);
+  for (int i = 0; i < envs.n_clusters; i++) {
+    EXPECT_NEAR(self_kern(i), kern_mat(i, i), 1e-10);
+  }
+}
+
 TYPED_TEST(KernelTest, SqExpGrad) {
   // Test envs_envs_grad and envs_struc_grad methods of squared exponential
   // kernel.
@@ -784,3 +800,42 @@ TYPED_TEST(KernelTest, StressStressKernel) {
     }
   }
 }
+
+// Forming the force/force kernels in blocks of one atom should reproduce the
+// single block result.
+TEST_F(StructureTest, StrucStrucBlocks) {
+  DescriptorValues desc_1 = test_struc.descriptors[0];
+  DescriptorValues desc_2 = test_struc_2.descriptors[0];
+
+  // With power 1, the dot product force kernel diverges for orthogonal
+  // descriptors.
+  double kernel_power = 2;
+  NormalizedDotProduct norm_dot(sigma, kernel_power);
+  DotProduct dot(sigma, kernel_power);
+  NormalizedDotProduct_ICM norm_dot_icm(sigma, kernel_power, icm_coeffs);
+
+  Eigen::MatrixXd full_1 =
+      norm_dot.struc_struc(desc_1, desc_2, norm_dot.kernel_hyperparameters);
+  Eigen::MatrixXd full_2 =
+      dot.struc_struc(desc_1, desc_2, dot.kernel_hyperparameters);
+  Eigen::MatrixXd full_3 = norm_dot_icm.struc_struc(
+      desc_1, desc_2, norm_dot_icm.kernel_hyperparameters);
+
+  norm_dot.max_block_entries = 1;
+  dot.max_block_entries = 1;
+  norm_dot_icm.max_block_entries = 1;
+
+  Eigen::MatrixXd block_1 =
+      norm_dot.struc_struc(desc_1, desc_2, norm_dot.kernel_hyperparameters);
+  Eigen::MatrixXd block_2 =
+      dot.struc_struc(desc_1, desc_2, dot.kernel_hyperparameters);
+  Eigen::MatrixXd block_3 = norm_dot_icm.struc_struc(
+      desc_1, desc_2, norm_dot_icm.kernel_hyperparameters);
+
+  double thresh = 1e-12;
+  EXPECT_LE((full_1 - block_1).norm(), thresh * full_1.norm());
+  EXPECT_LE((full_2 - block_2).norm(), thresh * full_2.norm());
+  EXPECT_LE((full_3 - block_3).norm(), thresh * full_3.norm());
+  EXPECT_GT(full_1.norm(), 0);
+  EXPECT_GT(full_3.norm(), 0);
+}
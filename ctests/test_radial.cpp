@@ -342,3 +342,135 @@ TEST_F(RadialTest, CombDerv) {
     EXPECT_LE(z_diff, tolerance);
   }
 }
+
+TEST(RadialTableTest, MatchesCalculateRadial) {
+  // The tabulated basis should match calculate_radial across the support,
+  // including just inside r_min and the cutoff, and vanish outside it.
+  double r_min = 0.5;
+  double rcut = 5;
+  int N = 8;
+  std::vector<double> radial_hyps{r_min, rcut}, cutoff_hyps;
+  std::vector<std::string> basis_names{"chebyshev", "weighted_chebyshev",
+                                       "bessel"};
+  std::vector<std::string> cutoff_names{"cosine", "quadratic"};
+
+  for (int b = 0; b < basis_names.size(); b++) {
+    for (int c = 0; c < cutoff_names.size(); c++) {
+      std::function<void(std::vector<double> &, std::vector<double> &, double,
+                         int, std::vector<double>)>
+          basis_function;
+      std::function<void(std::vector<double> &, double, double,
+                         std::vector<double>)>
+          cutoff_function;
+      set_radial_basis(basis_names[b], basis_function);
+      set_cutoff(cutoff_names[c], cutoff_function);
+      std::vector<double> hyps = radial_hyps;
+      if (basis_names[b] == "weighted_chebyshev")
+        hyps.push_back(5);
+
+      RadialTable table(basis_function, cutoff_function, r_min, rcut, N, hyps,
+                        cutoff_hyps);
+
+      std::vector<double> distances{r_min + 1e-9, r_min + 1e-4,
+                                    r_min + 0.3 * table.spacing};
+      for (int k = 1; k < 20; k++)
+        distances.push_back(r_min + (rcut - r_min) * (k + 0.137) / 20);
+      distances.push_back(rcut - 0.3 * table.spacing);
+      distances.push_back(rcut - 1e-9);
+
+      // Direction of the bond.
+      double ux = 0.48, uy = -0.36, uz = 0.8;
+      for (int d = 0; d < distances.size(); d++) {
+        double r = distances[d];
+        double x = ux * r, y = uy * r, z = uz * r;
+        SCOPED_TRACE(basis_names[b] + " " + cutoff_names[c] + " r = " +
+                     std::to_string(r));
+
+        std::vector<double> g(N, 0), gx(N, 0), gy(N, 0), gz(N, 0);
+        calculate_radial(g, gx, gy, gz, basis_function, cutoff_function, x, y,
+                         z, r, rcut, N, hyps, cutoff_hyps);
+        std::vector<double> t(N, 0), tx(N, 0), ty(N, 0), tz(N, 0);
+        table.calculate_radial(t.data(), tx.data(), ty.data(), tz.data(), x,
+                               y, z, r);
+
+        // The spline error scales with the higher derivatives of the
+        // basis, which are largest in the first interval for the steep
+        // weighted Chebyshev and Bessel bases.
+        for (int n = 0; n < N; n++) {
+          EXPECT_NEAR(t[n], g[n], 1e-7 * (1 + abs(g[n])));
+          EXPECT_NEAR(tx[n], gx[n], 1e-5 * (1 + abs(gx[n])));
+          EXPECT_NEAR(ty[n], gy[n], 1e-5 * (1 + abs(gy[n])));
+          EXPECT_NEAR(tz[n], gz[n], 1e-5 * (1 + abs(gz[n])));
+        }
+      }
+
+      std::vector<double> outside{r_min - 1e-3, rcut + 1e-9, rcut + 1};
+      for (int d = 0; d < outside.size(); d++) {
+        double r = outside[d];
+        std::vector<double> t(N, 1), tx(N, 1), ty(N, 1), tz(N, 1);
+        table.calculate_radial(t.data(), tx.data(), ty.data(), tz.data(),
+                               ux * r, uy * r, uz * r, r);
+        for (int n = 0; n < N; n++) {
+          EXPECT_EQ(t[n], 0);
+          EXPECT_EQ(tx[n], 0);
+          EXPECT_EQ(ty[n], 0);
+          EXPECT_EQ(tz[n], 0);
+        }
+      }
+    }
+  }
+}
+
+TEST(RadialTableTest, DerivativesMatchValues) {
+  // The returned derivatives are those of the spline, so they agree with
+  // finite differences of the tabulated values to high precision, also
+  // across grid points.
+  double rcut = 5;
+  int N = 8;
+  std::vector<double> radial_hyps{0, rcut}, cutoff_hyps;
+  RadialTable table(chebyshev, cos_cutoff, 0, rcut, N, radial_hyps,
+                    cutoff_hyps, 64);
+
+  double delta = 1e-6;
+  std::vector<double> distances{0.1, 1.2345, 2 * table.spacing, 3.7,
+                                rcut - 0.01};
+  for (int d = 0; d < distances.size(); d++) {
+    double r = distances[d];
+    std::vector<double> t(N), tx(N), ty(N), tz(N);
+    std::vector<double> t_up(N), t_down(N), dummy(3 * N);
+    table.calculate_radial(t.data(), tx.data(), ty.data(), tz.data(), r, 0, 0,
+                           r);
+    table.calculate_radial(t_up.data(), dummy.data(), dummy.data() + N,
+                           dummy.data() + 2 * N, r + delta, 0, 0, r + delta);
+    table.calculate_radial(t_down.data(), dummy.data(), dummy.data() + N,
+                           dummy.data() + 2 * N, r - delta, 0, 0, r - delta);
+    for (int n = 0; n < N; n++) {
+      EXPECT_NEAR((t_up[n] - t_down[n]) / (2 * delta), tx[n], 1e-7);
+    }
+  }
+}
+
+TEST(RadialTableTest, BasisMin) {
+  // The Gaussian tables start at 0, since the first Gaussian hyperparameter
+  // is the width, so bonds shorter than the width are still tabulated.
+  double rcut = 5;
+  int N = 4;
+  std::vector<double> gauss_hyps{0.8, 0, rcut}, cutoff_hyps;
+  EXPECT_EQ(radial_basis_min("equispaced_gaussians", gauss_hyps), 0);
+  std::vector<double> chebyshev_hyps{0.5, rcut};
+  EXPECT_EQ(radial_basis_min("chebyshev", chebyshev_hyps), 0.5);
+
+  RadialTable table(equispaced_gaussians, cos_cutoff,
+                    radial_basis_min("equispaced_gaussians", gauss_hyps), rcut,
+                    N, gauss_hyps, cutoff_hyps);
+  double r = 0.4;
+  std::vector<double> g(N, 0), gx(N, 0), gy(N, 0), gz(N, 0);
+  calculate_radial(g, gx, gy, gz, equispaced_gaussians, cos_cutoff, r, 0, 0, r,
+                   rcut, N, gauss_hyps, cutoff_hyps);
+  std::vector<double> t(N, 0), tx(N, 0), ty(N, 0), tz(N, 0);
+  table.calculate_radial(t.data(), tx.data(), ty.data(), tz.data(), r, 0, 0, r);
+  for (int n = 0; n < N; n++) {
+    EXPECT_GT(std::abs(g[n]), 0);
+    EXPECT_NEAR(t[n], g[n], 1e-7 * (1 + std::abs(g[n])));
+  }
+}
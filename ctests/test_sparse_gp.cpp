@@ -1,3 +1,4 @@
+#include "gp.h"
 #include "sparse_gp.h"
 #include "test_structure.h"
 #include <thread>
@@ -271,11 +272,11 @@ TEST_F(StructureTest, LikeGradStable) {
   // Check the likelihood function.
   double like_original = sparse_gp.compute_likelihood_gradient(hyps);
   Eigen::VectorXd like_grad_original = sparse_gp.likelihood_gradient;
-  EXPECT_NEAR(like, like_original, 1e-7);
+  EXPECT_NEAR(like, like_original, 1e-11 * abs(like_original));
 
   int n_hyps = hyps.size();
   Eigen::VectorXd hyps_up, hyps_down;
-  double pert = 1e-6, like_up, like_down, fin_diff;
+  double pert = 1e-4, like_up, like_down, fin_diff;
 
   for (int i = 0; i < n_hyps; i++) {
     hyps_up = hyps;
@@ -299,6 +300,15 @@ TEST_F(StructureTest, LikeGradStable) {
     EXPECT_NEAR(like_grad(i), fin_diff, 1e-5 * abs(fin_diff));
     EXPECT_NEAR(like_grad(i), like_grad_original(i), 1e-6 * abs(fin_diff));
   }
+
+  // Check the gradient computed from the kernel gradients directly.
+  sparse_gp.set_hyperparameters(hyps);
+  double like_direct = sparse_gp.compute_likelihood_gradient_stable();
+  EXPECT_NEAR(like_direct, like_original, 1e-11 * abs(like_original));
+  for (int i = 0; i < n_hyps; i++) {
+    EXPECT_NEAR(sparse_gp.likelihood_gradient(i), like_grad_original(i),
+                1e-6 * abs(like_grad_original(i)));
+  }
 }
 
 
@@ -407,3 +417,749 @@ TEST_F(StructureTest, AddOrder) {
     }
   }
 }
+
+TEST_F(StructureTest, IncrementalQR) {
+  // Check that updating the factorization as structures and sparse
+  // environments are added matches a factorization computed from scratch.
+  double sigma_e = 0.5;
+  double sigma_f = 0.2;
+  double sigma_s = 0.3;
+
+  std::vector<Kernel *> kernels;
+  kernels.push_back(&kernel_norm);
+  SparseGP sparse_gp_1 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_2 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  test_struc.energy = Eigen::VectorXd::Random(1);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc.stresses = Eigen::VectorXd::Random(6);
+  test_struc_2.energy = Eigen::VectorXd::Random(1);
+  test_struc_2.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc_3.energy = Eigen::VectorXd::Random(1);
+  test_struc_3.forces = Eigen::VectorXd::Random(n_atoms * 3);
+
+  // Update the first GP after every addition.
+  sparse_gp_1.add_training_structure(test_struc);
+  sparse_gp_1.add_specific_environments(test_struc, {0, 1, 2, 3, 4, 5});
+  sparse_gp_1.update_matrices_QR();
+  sparse_gp_1.add_training_structure(test_struc_2, {0, 2, 4});
+  sparse_gp_1.update_matrices_QR();
+  sparse_gp_1.add_specific_environments(test_struc_2, {1, 3, 6});
+  sparse_gp_1.update_matrices_QR();
+  sparse_gp_1.add_training_structure(test_struc_3);
+  sparse_gp_1.add_specific_environments(test_struc_3, {2, 7});
+  sparse_gp_1.update_matrices_QR();
+
+  // Factor the second GP once.
+  sparse_gp_2.add_training_structure(test_struc);
+  sparse_gp_2.add_specific_environments(test_struc, {0, 1, 2, 3, 4, 5});
+  sparse_gp_2.add_training_structure(test_struc_2, {0, 2, 4});
+  sparse_gp_2.add_specific_environments(test_struc_2, {1, 3, 6});
+  sparse_gp_2.add_training_structure(test_struc_3);
+  sparse_gp_2.add_specific_environments(test_struc_3, {2, 7});
+  sparse_gp_2.update_matrices_QR();
+
+  int n_sparse = sparse_gp_1.n_sparse;
+  EXPECT_EQ(n_sparse, sparse_gp_2.n_sparse);
+  for (int i = 0; i < n_sparse; i++) {
+    EXPECT_NEAR(sparse_gp_1.alpha(i), sparse_gp_2.alpha(i),
+                1e-6 * (1 + abs(sparse_gp_2.alpha(i))));
+    for (int j = 0; j < n_sparse; j++) {
+      EXPECT_NEAR(sparse_gp_1.Sigma(i, j), sparse_gp_2.Sigma(i, j),
+                  1e-6 * (1 + abs(sparse_gp_2.Sigma(i, j))));
+      EXPECT_NEAR(sparse_gp_1.L_inv(i, j), sparse_gp_2.L_inv(i, j),
+                  1e-6 * (1 + abs(sparse_gp_2.L_inv(i, j))));
+    }
+  }
+
+  sparse_gp_1.compute_likelihood_stable();
+  sparse_gp_2.compute_likelihood_stable();
+  EXPECT_NEAR(sparse_gp_1.log_marginal_likelihood,
+              sparse_gp_2.log_marginal_likelihood,
+              1e-6 * abs(sparse_gp_2.log_marginal_likelihood));
+}
+
+TEST_F(StructureTest, IncrementalQRCrossType) {
+  // With a kernel that couples environments of different types, new
+  // environments are factored out of Kuu order. L_inv should still be the
+  // lower triangular inverse factor of Kuu.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  Eigen::MatrixXd coupled_coeffs(3, 3);
+  coupled_coeffs << 1, 0.6, 0.5, 0.6, 1, 0.4, 0.5, 0.4, 1;
+  NormalizedDotProduct_ICM kernel_icm =
+      NormalizedDotProduct_ICM(sigma, 2, coupled_coeffs);
+  std::vector<Kernel *> kernels{&kernel_icm};
+  SparseGP sparse_gp_1 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_2 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  // Deterministic labels, to leave the random state of later tests as is.
+  test_struc.energy = Eigen::VectorXd::Constant(1, 0.5);
+  test_struc.forces = Eigen::VectorXd::LinSpaced(n_atoms * 3, -1, 1);
+  test_struc_2.forces = Eigen::VectorXd::LinSpaced(n_atoms * 3, 1, -1);
+
+  sparse_gp_1.add_training_structure(test_struc);
+  sparse_gp_1.add_specific_environments(test_struc, {1, 2, 3, 4, 5, 6, 7});
+  sparse_gp_1.update_matrices_QR();
+  sparse_gp_1.add_training_structure(test_struc_2);
+  sparse_gp_1.add_specific_environments(test_struc, {0, 8, 9});
+  sparse_gp_1.update_matrices_QR();
+  EXPECT_FALSE(kernel_icm.type_diagonal());
+
+  sparse_gp_2.add_training_structure(test_struc);
+  sparse_gp_2.add_specific_environments(test_struc, {1, 2, 3, 4, 5, 6, 7});
+  sparse_gp_2.add_training_structure(test_struc_2);
+  sparse_gp_2.add_specific_environments(test_struc, {0, 8, 9});
+  sparse_gp_2.update_matrices_QR();
+
+  int n_sparse = sparse_gp_1.n_sparse;
+  Eigen::MatrixXd L_inv = sparse_gp_1.L_inv;
+  Eigen::MatrixXd Kuu_jittered =
+      sparse_gp_1.Kuu +
+      sparse_gp_1.Kuu_jitter * Eigen::MatrixXd::Identity(n_sparse, n_sparse);
+  double thresh = 1e-6;
+  EXPECT_EQ(L_inv.triangularView<Eigen::StrictlyUpper>().toDenseMatrix().norm(),
+            0);
+  EXPECT_NEAR((L_inv * Kuu_jittered * L_inv.transpose() -
+               Eigen::MatrixXd::Identity(n_sparse, n_sparse))
+                  .cwiseAbs()
+                  .maxCoeff(),
+              0, thresh);
+  EXPECT_NEAR((L_inv - sparse_gp_2.L_inv).cwiseAbs().maxCoeff(), 0, thresh);
+  EXPECT_NEAR((sparse_gp_1.alpha - sparse_gp_2.alpha).cwiseAbs().maxCoeff(), 0,
+              thresh);
+}
+
+TEST_F(StructureTest, CrossTypeClusterVariances) {
+  // Cluster variances of a model with a kernel that couples types, updated
+  // incrementally, should match the variances computed from Kuu directly.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  Eigen::MatrixXd coupled_coeffs(3, 3);
+  coupled_coeffs << 1, 0.6, 0.5, 0.6, 1, 0.4, 0.5, 0.4, 1;
+  NormalizedDotProduct_ICM kernel_icm =
+      NormalizedDotProduct_ICM(sigma, 2, coupled_coeffs);
+  std::vector<Kernel *> kernels{&kernel_icm};
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  // Deterministic labels, to leave the random state of later tests as is.
+  test_struc.energy = Eigen::VectorXd::Constant(1, 0.5);
+  test_struc.forces = Eigen::VectorXd::LinSpaced(n_atoms * 3, -1, 1);
+  test_struc_2.forces = Eigen::VectorXd::LinSpaced(n_atoms * 3, 1, -1);
+
+  sparse_gp.add_training_structure(test_struc);
+  sparse_gp.add_specific_environments(test_struc, {1, 2, 3, 4, 5, 6, 7});
+  sparse_gp.update_matrices_QR();
+  sparse_gp.add_training_structure(test_struc_2);
+  sparse_gp.add_specific_environments(test_struc, {0, 8, 9});
+  sparse_gp.update_matrices_QR();
+
+  ClusterDescriptor clusters(test_struc_2.descriptors[0]);
+  Eigen::VectorXd K_self = kernel_icm.self_kernel_envs(
+      clusters, kernel_icm.kernel_hyperparameters);
+  double thresh = 1e-6;
+  auto check_variances = [&]() {
+    Eigen::MatrixXd sparse_kernels = kernel_icm.envs_envs(
+        clusters, sparse_gp.sparse_descriptors[0],
+        kernel_icm.kernel_hyperparameters);
+    Eigen::MatrixXd projections;
+    Eigen::VectorXd variances = sparse_gp.compute_cluster_variances(
+        0, clusters, sparse_kernels, &projections);
+
+    int n_sparse = sparse_gp.n_sparse;
+    Eigen::MatrixXd Kuu_jittered =
+        sparse_gp.Kuu +
+        sparse_gp.Kuu_jitter * Eigen::MatrixXd::Identity(n_sparse, n_sparse);
+    Eigen::MatrixXd Q = sparse_kernels *
+                        Kuu_jittered.llt().solve(sparse_kernels.transpose());
+    EXPECT_NEAR((variances - (K_self - Q.diagonal())).cwiseAbs().maxCoeff(),
+                0, thresh);
+    EXPECT_NEAR(
+        (projections.transpose() * projections - Q).cwiseAbs().maxCoeff(), 0,
+        thresh);
+  };
+  check_variances();
+
+  // Removing environments downdates the factors in factor order.
+  sparse_gp.remove_sparse_environments({{0, 8}});
+  sparse_gp.update_matrices_QR();
+  check_variances();
+}
+
+TEST_F(StructureTest, CompactTraining) {
+  // Kuf computed from compressed training structures should match the full
+  // calculation for sparse environments that lie in the stored span.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels;
+  kernels.push_back(&kernel_norm);
+  SparseGP sparse_gp_1 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_2 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  sparse_gp_2.compact_training = true;
+
+  test_struc.energy = Eigen::VectorXd::Random(1);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc.stresses = Eigen::VectorXd::Random(6);
+  test_struc_2.energy = Eigen::VectorXd::Random(1);
+  test_struc_2.forces = Eigen::VectorXd::Random(n_atoms * 3);
+
+  std::vector<SparseGP *> gps{&sparse_gp_1, &sparse_gp_2};
+  for (int i = 0; i < gps.size(); i++) {
+    gps[i]->add_all_environments(test_struc_2);
+    gps[i]->add_training_structure(test_struc);
+    gps[i]->add_all_environments(test_struc);
+    gps[i]->add_training_structure(test_struc_2);
+    gps[i]->update_matrices_QR();
+  }
+
+  const DescriptorValues &compact_desc =
+      sparse_gp_2.training_structures[0].descriptors[0];
+  EXPECT_TRUE(compact_desc.compressed());
+  EXPECT_EQ(sparse_gp_2.training_structures[0].relative_positions.size(), 0);
+  for (int s = 0; s < compact_desc.n_types; s++) {
+    EXPECT_LT(compact_desc.descriptor_force_dervs[s].cols(),
+              compact_desc.n_descriptors);
+  }
+
+  for (int i = 0; i < sparse_gp_1.Kuf.rows(); i++) {
+    for (int j = 0; j < sparse_gp_1.Kuf.cols(); j++) {
+      EXPECT_NEAR(sparse_gp_1.Kuf(i, j), sparse_gp_2.Kuf(i, j), 1e-10);
+    }
+  }
+}
+
+TEST_F(StructureTest, CompactTrainingNewSpan) {
+  // Sparse environments from another frame generally lie outside the span a
+  // training structure was compressed against. Kuf should still match the
+  // full calculation. The structure is then stored in full, or compressed
+  // again against the enlarged sparse set if recompress_training is set.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels;
+  kernels.push_back(&kernel_norm);
+  SparseGP sparse_gp_1 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_2 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_3 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  sparse_gp_2.compact_training = true;
+  sparse_gp_3.compact_training = true;
+  sparse_gp_3.recompress_training = true;
+
+  test_struc.energy = Eigen::VectorXd::Random(1);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc.stresses = Eigen::VectorXd::Random(6);
+
+  std::vector<SparseGP *> gps{&sparse_gp_1, &sparse_gp_2, &sparse_gp_3};
+  for (int i = 0; i < gps.size(); i++) {
+    gps[i]->add_specific_environments(test_struc, {0, 1});
+    gps[i]->add_training_structure(test_struc);
+    gps[i]->add_specific_environments(test_struc_2, {0, 1, 2, 3});
+    gps[i]->update_matrices_QR();
+  }
+
+  const Structure &full_struc = sparse_gp_2.training_structures[0];
+  EXPECT_FALSE(full_struc.descriptors[0].compressed());
+  EXPECT_EQ(full_struc.relative_positions.size(), 0);
+
+  const Structure &compact_struc = sparse_gp_3.training_structures[0];
+  const DescriptorValues &compact_desc = compact_struc.descriptors[0];
+  EXPECT_TRUE(compact_desc.compressed());
+  EXPECT_EQ(compact_struc.relative_positions.size(), 0);
+  ClusterDescriptor new_envs(
+      test_struc_2.descriptors[0],
+      test_struc_2.descriptors[0].clusters_of_atoms({0, 1, 2, 3}));
+  EXPECT_TRUE(compact_desc.force_dervs_span_contains(new_envs));
+
+  for (int k = 1; k < gps.size(); k++) {
+    for (int i = 0; i < sparse_gp_1.Kuf.rows(); i++) {
+      for (int j = 0; j < sparse_gp_1.Kuf.cols(); j++) {
+        EXPECT_NEAR(sparse_gp_1.Kuf(i, j), gps[k]->Kuf(i, j), 1e-10);
+      }
+    }
+    for (int i = 0; i < sparse_gp_1.alpha.size(); i++) {
+      EXPECT_NEAR(sparse_gp_1.alpha(i), gps[k]->alpha(i), 1e-8);
+    }
+  }
+}
+
+TEST_F(StructureTest, BatchPredict) {
+  // Batched predictions should match predictions made one structure at a
+  // time.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  // The DTC variance includes the self kernel of each structure, whose
+  // force terms carry a factor norm_dot^(power - 2) that diverges for
+  // orthogonal environments when the power is 1 (see
+  // NormalizedDotProduct::self_kernel_struc). The random test structures can
+  // contain such pairs, so DTC is checked with a quadratic kernel, and the
+  // mean and SOR predictions with the linear kernel of the fixture.
+  NormalizedDotProduct kernel_sq = NormalizedDotProduct(sigma, 2);
+  std::vector<Kernel *> kernels_linear{&kernel_norm};
+  std::vector<Kernel *> kernels_sq{&kernel_sq};
+  SparseGP sparse_gp = SparseGP(kernels_linear, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_sq = SparseGP(kernels_sq, sigma_e, sigma_f, sigma_s);
+
+  test_struc.energy = Eigen::VectorXd::Random(1);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc.stresses = Eigen::VectorXd::Random(6);
+  std::vector<SparseGP *> gps{&sparse_gp, &sparse_gp_sq};
+  for (int i = 0; i < gps.size(); i++) {
+    gps[i]->add_training_structure(test_struc);
+    gps[i]->add_specific_environments(test_struc, {0, 1, 2, 3, 4});
+    gps[i]->update_matrices_QR();
+  }
+
+  std::vector<Structure> batch{test_struc, test_struc_2, test_struc_3};
+  std::vector<Structure *> batch_pointers;
+  for (int i = 0; i < batch.size(); i++)
+    batch_pointers.push_back(&batch[i]);
+
+  std::vector<Structure> single = batch;
+  sparse_gp.predict_mean_batch(batch_pointers);
+  for (int s = 0; s < batch.size(); s++) {
+    sparse_gp.predict_mean(single[s]);
+    for (int i = 0; i < single[s].mean_efs.size(); i++) {
+      EXPECT_NEAR(batch[s].mean_efs(i), single[s].mean_efs(i), 1e-8);
+    }
+  }
+
+  sparse_gp.predict_SOR_batch(batch_pointers);
+  for (int s = 0; s < batch.size(); s++) {
+    sparse_gp.predict_SOR(single[s]);
+    for (int i = 0; i < single[s].mean_efs.size(); i++) {
+      EXPECT_NEAR(batch[s].mean_efs(i), single[s].mean_efs(i), 1e-8);
+      EXPECT_NEAR(batch[s].variance_efs(i), single[s].variance_efs(i), 1e-8);
+    }
+  }
+
+  sparse_gp_sq.predict_DTC_batch(batch_pointers);
+  for (int s = 0; s < batch.size(); s++) {
+    sparse_gp_sq.predict_DTC(single[s]);
+    for (int i = 0; i < single[s].mean_efs.size(); i++) {
+      EXPECT_NEAR(batch[s].mean_efs(i), single[s].mean_efs(i), 1e-8);
+      EXPECT_NEAR(batch[s].variance_efs(i), single[s].variance_efs(i), 1e-8);
+    }
+  }
+}
+
+TEST_F(StructureTest, CachedKufGrads) {
+  // Kuf gradients evaluated from cached contractions should match a model
+  // built from scratch at the new hyperparameters and finite differences.
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels{&kernel};
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  test_struc.energy = Eigen::VectorXd::Random(1);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc.stresses = Eigen::VectorXd::Random(6);
+  test_struc_2.energy = Eigen::VectorXd::Random(1);
+  test_struc_2.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  sparse_gp.add_training_structure(test_struc);
+  sparse_gp.add_training_structure(test_struc_2, {0, 2, 3});
+  sparse_gp.add_specific_environments(test_struc, {0, 1, 2});
+  sparse_gp.update_matrices_QR();
+
+  // Fill the cache at the current hyperparameters.
+  Eigen::VectorXd hyps = sparse_gp.hyperparameters;
+  std::vector<std::vector<Eigen::MatrixXd>> Kuf_grads =
+      sparse_gp.compute_Kuf_grads(hyps);
+  EXPECT_EQ(sparse_gp.Kuf_contractions[0].size(), 2);
+  EXPECT_GT(sparse_gp.Kuf_contractions_bytes, 0);
+  EXPECT_NEAR((Kuf_grads[0][0] - sparse_gp.Kuf).cwiseAbs().maxCoeff(), 0,
+              1e-12);
+
+  Eigen::VectorXd new_hyps = hyps;
+  new_hyps(0) *= 1.3;
+  new_hyps(1) *= 0.8;
+  Kuf_grads = sparse_gp.compute_Kuf_grads(new_hyps);
+
+  SquaredExponential new_kernel(new_hyps(0), new_hyps(1));
+  std::vector<Kernel *> new_kernels{&new_kernel};
+  SparseGP new_gp = SparseGP(new_kernels, sigma_e, sigma_f, sigma_s);
+  new_gp.add_training_structure(test_struc);
+  new_gp.add_training_structure(test_struc_2, {0, 2, 3});
+  new_gp.add_specific_environments(test_struc, {0, 1, 2});
+  EXPECT_NEAR((Kuf_grads[0][0] - new_gp.Kuf).cwiseAbs().maxCoeff(), 0, 1e-12);
+
+  double pert = 1e-6;
+  for (int h = 0; h < 2; h++) {
+    Eigen::VectorXd hyps_up = new_hyps, hyps_down = new_hyps;
+    hyps_up(h) += pert;
+    hyps_down(h) -= pert;
+    Eigen::MatrixXd fin_diff = (sparse_gp.compute_Kuf_grads(hyps_up)[0][0] -
+                                sparse_gp.compute_Kuf_grads(hyps_down)[0][0]) /
+                               (2 * pert);
+    double scale = fin_diff.cwiseAbs().maxCoeff();
+    EXPECT_NEAR((Kuf_grads[0][h + 1] - fin_diff).cwiseAbs().maxCoeff(), 0,
+                1e-6 * scale);
+  }
+
+  // Without a cache, the contractions are recomputed on each call and give
+  // the same gradients.
+  SparseGP uncached_gp = sparse_gp;
+  uncached_gp.clear_Kuf_contractions();
+  uncached_gp.Kuf_contractions_limit = 0;
+  std::vector<std::vector<Eigen::MatrixXd>> uncached_grads =
+      uncached_gp.compute_Kuf_grads(new_hyps);
+  EXPECT_EQ(uncached_gp.Kuf_contractions_bytes, 0);
+  for (int j = 0; j < uncached_gp.Kuf_contractions[0].size(); j++) {
+    EXPECT_EQ(uncached_gp.Kuf_contractions[0][j].size(), 0);
+  }
+  for (int k = 0; k < Kuf_grads[0].size(); k++) {
+    EXPECT_NEAR((uncached_grads[0][k] - Kuf_grads[0][k]).cwiseAbs().maxCoeff(),
+                0, 1e-12);
+  }
+}
+
+TEST_F(StructureTest, ExactGP) {
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels;
+  kernels.push_back(&kernel);
+  GP gp = GP(kernels, sigma_e, sigma_f, sigma_s);
+
+  test_struc.energy = Eigen::VectorXd::Random(1);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  test_struc.stresses = Eigen::VectorXd::Random(6);
+  test_struc_2.forces = Eigen::VectorXd::Random(n_atoms * 3);
+
+  // Factor after each structure so that the second update extends the
+  // Cholesky factor with a block update.
+  gp.add_training_structure(test_struc);
+  gp.update_matrices();
+  gp.add_training_structure(test_struc_2);
+  gp.update_matrices();
+
+  int n_labels = 1 + 3 * n_atoms + 6 + 3 * n_atoms;
+  EXPECT_EQ(gp.n_labels, n_labels);
+  EXPECT_EQ(gp.label_count(1), 1 + 3 * n_atoms + 6);
+
+  // The cross block matches a direct struc_struc call.
+  Eigen::MatrixXd cross = kernel.struc_struc(
+      test_struc.descriptors[0], test_struc_2.descriptors[0],
+      kernel.kernel_hyperparameters);
+  double thresh = 1e-10;
+  for (int i = 0; i < 3 * n_atoms; i++) {
+    EXPECT_NEAR(gp.Kff(0, 1 + 3 * n_atoms + 6 + i), cross(0, 1 + i), thresh);
+    EXPECT_NEAR(gp.Kff(1 + 3 * n_atoms + 6 + i, 0), cross(0, 1 + i), thresh);
+  }
+
+  Eigen::MatrixXd K_noise =
+      gp.Kff + Eigen::MatrixXd((1 / gp.noise_vector.array()).matrix().asDiagonal());
+  Eigen::MatrixXd L = gp.L;
+  EXPECT_NEAR((L * L.transpose() - K_noise).norm(), 0, thresh);
+
+  Eigen::LDLT<Eigen::MatrixXd> ldlt(K_noise);
+  Eigen::VectorXd alpha = ldlt.solve(gp.y);
+  EXPECT_NEAR((gp.alpha - alpha).norm(), 0, thresh * alpha.norm());
+
+  // Predictions match the dense solve.
+  Structure test_struc_3 = test_struc;
+  gp.predict(test_struc_3);
+  Eigen::MatrixXd kernel_mat = gp.struc_kernel_matrix(test_struc_3);
+  Eigen::VectorXd mean = kernel_mat.transpose() * alpha;
+  Eigen::VectorXd variance =
+      kernel.self_kernel_struc(test_struc_3.descriptors[0],
+                               kernel.kernel_hyperparameters) -
+      (kernel_mat.transpose() * ldlt.solve(kernel_mat)).diagonal();
+  for (int i = 0; i < mean.size(); i++) {
+    EXPECT_NEAR(test_struc_3.mean_efs(i), mean(i), thresh);
+    EXPECT_NEAR(test_struc_3.variance_efs(i), variance(i), thresh);
+  }
+
+  // Likelihood matches the dense log determinant.
+  gp.compute_likelihood();
+  double log_det = ldlt.vectorD().array().log().sum();
+  EXPECT_NEAR(gp.complexity_penalty, -log_det / 2, thresh);
+
+  // Resetting the hyperparameters rebuilds the same factorization.
+  gp.set_hyperparameters(gp.hyperparameters);
+  EXPECT_NEAR((gp.L - L).norm(), 0, thresh);
+}
+
+TEST_F(StructureTest, KufKernelBlocks) {
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  // Two kernels, so that Kuf stacks two blocks of rows.
+  std::vector<Descriptor *> dc_2{&ps_norm, &ps_norm};
+  Structure struc_1 = Structure(cell, species, positions, cutoff, dc_2);
+  Structure struc_2 = Structure(cell_2, species_2, positions_2, cutoff, dc_2);
+  struc_1.energy = Eigen::VectorXd::Random(1);
+  struc_1.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  struc_2.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  struc_2.stresses = Eigen::VectorXd::Random(6);
+
+  std::vector<Kernel *> kernels{&kernel, &kernel_norm};
+  SparseGP sparse_gp_1 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_2 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  // Interleave structures and environments of several types, so that new
+  // Kuf rows are inserted between the rows of earlier environments.
+  sparse_gp_1.add_training_structure(struc_1);
+  sparse_gp_1.add_specific_environments(struc_1, {0, 3});
+  sparse_gp_1.add_training_structure(struc_2, {1, 4});
+  sparse_gp_1.add_specific_environments(struc_2, {1, 2, 5});
+  sparse_gp_1.add_specific_environments(struc_1, {1, 2});
+
+  // Add all environments first, so that Kuf is only built column by column.
+  sparse_gp_2.add_specific_environments(struc_1, {0, 3});
+  sparse_gp_2.add_specific_environments(struc_2, {1, 2, 5});
+  sparse_gp_2.add_specific_environments(struc_1, {1, 2});
+  sparse_gp_2.add_training_structure(struc_1);
+  sparse_gp_2.add_training_structure(struc_2, {1, 4});
+
+  EXPECT_EQ(sparse_gp_1.Kuf.rows(), sparse_gp_1.n_sparse);
+  EXPECT_EQ(sparse_gp_1.Kuf.cols(), sparse_gp_1.n_labels);
+  EXPECT_NEAR((sparse_gp_1.Kuf - sparse_gp_2.Kuf).cwiseAbs().maxCoeff(), 0,
+              1e-12);
+
+  // Each kernel block matches a direct kernel evaluation.
+  for (int i = 0; i < 2; i++) {
+    Eigen::MatrixXd envs_struc = kernels[i]->envs_struc(
+        sparse_gp_1.sparse_descriptors[i], struc_1.descriptors[i],
+        kernels[i]->kernel_hyperparameters);
+    Eigen::MatrixXd Kuf_i = sparse_gp_1.Kuf_kernel(i);
+    EXPECT_EQ(Kuf_i.rows(), sparse_gp_1.sparse_descriptors[i].n_clusters);
+    EXPECT_NEAR((Kuf_i.leftCols(1 + 3 * n_atoms) -
+                 envs_struc.leftCols(1 + 3 * n_atoms))
+                    .cwiseAbs()
+                    .maxCoeff(),
+                0, 1e-12);
+  }
+}
+
+TEST_F(StructureTest, KuuTypeBlocks) {
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Descriptor *> dc_2{&ps_norm, &ps_norm};
+  Structure struc_1 = Structure(cell, species, positions, cutoff, dc_2);
+  Structure struc_2 = Structure(cell_2, species_2, positions_2, cutoff, dc_2);
+
+  std::vector<Kernel *> kernels{&kernel, &kernel_norm};
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+
+  // Kuu of type-diagonal kernels is grown from its diagonal type blocks,
+  // across several additions and a hyperparameter update.
+  sparse_gp.add_specific_environments(struc_1, {0, 3});
+  sparse_gp.add_specific_environments(struc_2, {1, 2, 5});
+  sparse_gp.add_specific_environments(struc_1, {1});
+  sparse_gp.set_hyperparameters(sparse_gp.hyperparameters);
+  sparse_gp.add_specific_environments(struc_2, {0, 3, 4, 6});
+
+  for (int i = 0; i < 2; i++) {
+    EXPECT_TRUE(kernels[i]->type_diagonal());
+    Eigen::MatrixXd Kuu_ref = kernels[i]->envs_envs(
+        sparse_gp.sparse_descriptors[i], sparse_gp.sparse_descriptors[i],
+        kernels[i]->kernel_hyperparameters);
+    EXPECT_NEAR((sparse_gp.Kuu_kernels[i] - Kuu_ref).cwiseAbs().maxCoeff(), 0,
+                1e-12);
+  }
+}
+
+TEST_F(StructureTest, ClusterUncertainties) {
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  NormalizedDotProduct_ICM kernel_icm =
+      NormalizedDotProduct_ICM(sigma, power, icm_coeffs);
+  std::vector<Descriptor *> dc_2{&ps_norm, &ps_norm};
+  Structure struc_1 = Structure(cell, species, positions, cutoff, dc_2);
+  Structure struc_2 = Structure(cell_2, species_2, positions_2, cutoff, dc_2);
+  struc_1.forces = Eigen::VectorXd::Random(n_atoms * 3);
+
+  std::vector<Kernel *> kernels{&kernel_norm, &kernel_icm};
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  sparse_gp.add_training_structure(struc_1);
+  sparse_gp.add_specific_environments(struc_1, {0, 3, 5});
+  sparse_gp.update_matrices_QR();
+  sparse_gp.add_specific_environments(struc_1, {1, 2});
+  sparse_gp.update_matrices_QR();
+
+  std::vector<Eigen::VectorXd> variances =
+      sparse_gp.compute_cluster_uncertainties(struc_2);
+
+  // Compare with the dense diagonal of K - K_su Kuu^-1 K_us.
+  int sparse_count = 0;
+  for (int i = 0; i < 2; i++) {
+    ClusterDescriptor envs(struc_2.descriptors[i]);
+    Eigen::MatrixXd K_self = kernels[i]->envs_envs(
+        envs, envs, kernels[i]->kernel_hyperparameters);
+    Eigen::MatrixXd K_su = kernels[i]->envs_envs(
+        envs, sparse_gp.sparse_descriptors[i],
+        kernels[i]->kernel_hyperparameters);
+    int n_clusters = sparse_gp.sparse_descriptors[i].n_clusters;
+    Eigen::MatrixXd L_inv = sparse_gp.L_inv.block(sparse_count, sparse_count,
+                                                   n_clusters, n_clusters);
+    sparse_count += n_clusters;
+    Eigen::MatrixXd Q = (L_inv * K_su.transpose()).transpose() *
+                        (L_inv * K_su.transpose());
+
+    Eigen::VectorXd self_kern = kernels[i]->self_kernel_envs(
+        envs, kernels[i]->kernel_hyperparameters);
+    for (int j = 0; j < envs.n_clusters; j++) {
+      EXPECT_NEAR(self_kern(j), K_self(j, j), 1e-10);
+      EXPECT_NEAR(variances[i](j), K_self(j, j) - Q(j, j), 1e-10);
+    }
+  }
+}
+
+TEST_F(StructureTest, UncertainSelection) {
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels{&kernel_norm};
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  test_struc.forces = Eigen::VectorXd::Random(n_atoms * 3);
+  sparse_gp.add_training_structure(test_struc);
+  sparse_gp.add_specific_environments(test_struc, {0, 1});
+  sparse_gp.update_matrices_QR();
+
+  // The selected atoms are the most uncertain ones.
+  int n_added = 4;
+  std::vector<std::vector<int>> sorted =
+      sparse_gp.sort_clusters_by_uncertainty(test_struc_2);
+  const DescriptorValues &desc = test_struc_2.descriptors[0];
+  std::vector<int> expected;
+  for (int j = 0; j < n_added; j++) {
+    int cluster = sorted[0][j];
+    for (int s = 0; s < desc.n_types; s++) {
+      if (cluster < desc.cumulative_type_count[s + 1]) {
+        expected.push_back(
+            desc.atom_indices[s](cluster - desc.cumulative_type_count[s]));
+        break;
+      }
+    }
+  }
+
+  sparse_gp.add_uncertain_environments(test_struc_2, {n_added});
+  std::vector<int> added = sparse_gp.sparse_indices[0].back();
+  EXPECT_EQ(added, expected);
+
+  // Kuu built from the reused candidate kernels matches a direct evaluation.
+  Eigen::MatrixXd Kuu_ref = kernel_norm.envs_envs(
+      sparse_gp.sparse_descriptors[0], sparse_gp.sparse_descriptors[0],
+      kernel_norm.kernel_hyperparameters);
+  EXPECT_NEAR((sparse_gp.Kuu - Kuu_ref).cwiseAbs().maxCoeff(), 0, 1e-12);
+
+  // In a simple cubic crystal all environments are equivalent, so diverse
+  // selection stops after the first one.
+  Eigen::MatrixXd lattice_cell = Eigen::MatrixXd::Identity(3, 3) * 6;
+  Eigen::MatrixXd lattice_positions(8, 3);
+  std::vector<int> lattice_species(8, 0);
+  for (int i = 0; i < 8; i++) {
+    lattice_positions.row(i) << 3 * (i % 2), 3 * ((i / 2) % 2), 3 * (i / 4);
+  }
+  Structure lattice =
+      Structure(lattice_cell, lattice_species, lattice_positions, 4, dc);
+
+  SparseGP sparse_gp_2 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  SparseGP sparse_gp_3 = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  sparse_gp_2.add_uncertain_environments(lattice, {3});
+  sparse_gp_3.add_uncertain_environments(lattice, {3}, true);
+  EXPECT_EQ(sparse_gp_2.n_sparse, 3);
+  EXPECT_EQ(sparse_gp_3.n_sparse, 1);
+}
+
+TEST_F(StructureTest, PruneSparseSet) {
+  double sigma_e = 1;
+  double sigma_f = 2;
+  double sigma_s = 3;
+
+  std::vector<Kernel *> kernels{&kernel_norm};
+  SparseGP sparse_gp = SparseGP(kernels, sigma_e, sigma_f, sigma_s);
+  // Deterministic labels, to leave the random state of later tests as is.
+  test_struc.energy = Eigen::VectorXd::Constant(1, 0.5);
+  test_struc.forces = Eigen::VectorXd::LinSpaced(n_atoms * 3, -1, 1);
+  test_struc.stresses = Eigen::VectorXd::LinSpaced(6, -1, 1);
+  sparse_gp.add_training_structure(test_struc);
+  sparse_gp.add_all_environments(test_struc);
+  sparse_gp.update_matrices_QR();
+
+  // Adding the same environments again makes them redundant.
+  sparse_gp.add_specific_environments(test_struc, {0, 1, 2});
+  sparse_gp.update_matrices_QR();
+  int n_before = sparse_gp.n_sparse;
+
+  std::vector<std::vector<int>> removed =
+      sparse_gp.prune_sparse_environments(1e-4);
+  EXPECT_GE(removed[0].size(), 3);
+  EXPECT_EQ(sparse_gp.n_sparse, n_before - removed[0].size());
+  EXPECT_EQ(sparse_gp.prune_sparse_environments(1e-4)[0].size(), 0);
+
+  // The compacted matrices match a direct evaluation.
+  const ClusterDescriptor &sparse = sparse_gp.sparse_descriptors[0];
+  Eigen::MatrixXd Kuu_ref =
+      kernel_norm.envs_envs(sparse, sparse, kernel_norm.kernel_hyperparameters);
+  Eigen::MatrixXd Kuf_ref = kernel_norm.envs_struc(
+      sparse, test_struc.descriptors[0], kernel_norm.kernel_hyperparameters);
+  EXPECT_NEAR((sparse_gp.Kuu - Kuu_ref).cwiseAbs().maxCoeff(), 0, 1e-12);
+  EXPECT_NEAR((sparse_gp.Kuf - Kuf_ref).cwiseAbs().maxCoeff(), 0, 1e-12);
+
+  // Each remaining environment is listed once in sparse_indices.
+  int n_indices = 0;
+  for (int i = 0; i < sparse_gp.sparse_indices[0].size(); i++) {
+    n_indices += sparse_gp.sparse_indices[0][i].size();
+  }
+  EXPECT_EQ(n_indices, sparse_gp.n_sparse);
+
+  // The downdated factors give the solution of a full refactorization.
+  SparseGP sparse_gp_2 = sparse_gp;
+  sparse_gp_2.factors_current = false;
+  sparse_gp_2.update_matrices_QR();
+  EXPECT_EQ(sparse_gp.factor_indices.size(), sparse_gp.n_sparse);
+  sparse_gp.update_matrices_QR();
+
+  double thresh = 1e-6;
+  EXPECT_NEAR((sparse_gp.alpha - sparse_gp_2.alpha).cwiseAbs().maxCoeff(), 0,
+              thresh);
+  EXPECT_NEAR((sparse_gp.Sigma - sparse_gp_2.Sigma).cwiseAbs().maxCoeff(), 0,
+              thresh);
+  EXPECT_NEAR((sparse_gp.L_inv - sparse_gp_2.L_inv).cwiseAbs().maxCoeff(), 0,
+              thresh);
+
+  // Removing a given environment, then adding labels.
+  sparse_gp.remove_sparse_environments({{1}});
+  test_struc_2.energy = Eigen::VectorXd::Constant(1, -0.5);
+  test_struc_2.forces = Eigen::VectorXd::LinSpaced(n_atoms * 3, 1, -1);
+  sparse_gp.add_training_structure(test_struc_2);
+  sparse_gp_2 = sparse_gp;
+  sparse_gp_2.factors_current = false;
+  sparse_gp.update_matrices_QR();
+  sparse_gp_2.update_matrices_QR();
+  EXPECT_NEAR((sparse_gp.alpha - sparse_gp_2.alpha).cwiseAbs().maxCoeff(), 0,
+              thresh);
+  EXPECT_NEAR((sparse_gp.Sigma - sparse_gp_2.Sigma).cwiseAbs().maxCoeff(), 0,
+              thresh);
+
+  // Invalid removals are rejected before the model is changed.
+  int n_sparse = sparse_gp.n_sparse;
+  EXPECT_THROW(sparse_gp.remove_sparse_environments({}),
+               std::invalid_argument);
+  EXPECT_THROW(sparse_gp.remove_sparse_environments({{n_sparse}}),
+               std::invalid_argument);
+  EXPECT_THROW(sparse_gp.remove_sparse_environments({{0, -1}}),
+               std::invalid_argument);
+  EXPECT_EQ(sparse_gp.n_sparse, n_sparse);
+  EXPECT_THROW(sparse_gp.sparse_descriptors[0].remove_clusters({n_sparse}),
+               std::invalid_argument);
+}
@@ -1,4 +1,7 @@
 #include "test_structure.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 TEST_F(StructureTest, TestWrapped) {
   // Check that the wrapped coordinates are equivalent to Cartesian coordinates
@@ -35,3 +38,145 @@ TEST_F(StructureTest, TestEnvironments) {
   ClusterDescriptor envs;
   envs.add_all_clusters(struc_desc);
 }
+
+TEST_F(StructureTest, CellListMatchesAllPairs) {
+  // Compare the linked-cell and all-pairs neighbor searches in a large
+  // triclinic cell and in a small cell that requires several image sweeps.
+  std::vector<Descriptor *> no_descriptors;
+  std::vector<double> cell_scales{12.0, 3.0};
+  std::vector<int> atom_counts{300, 7};
+  double test_cutoff = 4.5;
+
+  for (int t = 0; t < cell_scales.size(); t++) {
+    Eigen::MatrixXd tri_cell(3, 3);
+    tri_cell << 1.0, 0.0, 0.0, 0.3, 0.9, 0.0, -0.2, 0.25, 1.1;
+    tri_cell *= cell_scales[t];
+
+    int n_test = atom_counts[t];
+    Eigen::MatrixXd tri_positions =
+        Eigen::MatrixXd::Random(n_test, 3) * cell_scales[t];
+    std::vector<int> tri_species;
+    for (int i = 0; i < n_test; i++) {
+      tri_species.push_back(rand() % n_species);
+    }
+
+    Structure struc_1(tri_cell, tri_species, tri_positions, test_cutoff,
+                      no_descriptors);
+    Structure struc_2 = struc_1;
+    struc_1.compute_neighbors_all_pairs();
+    struc_2.compute_neighbors_cell_list();
+
+    EXPECT_EQ(struc_1.n_neighbors, struc_2.n_neighbors);
+    EXPECT_EQ(struc_1.neighbor_count, struc_2.neighbor_count);
+    EXPECT_EQ(struc_1.cumulative_neighbor_count,
+              struc_2.cumulative_neighbor_count);
+    EXPECT_EQ(struc_1.structure_indices, struc_2.structure_indices);
+    EXPECT_EQ(struc_1.neighbor_species, struc_2.neighbor_species);
+    EXPECT_EQ(struc_1.relative_positions, struc_2.relative_positions);
+  }
+}
+
+TEST_F(StructureTest, AtomClusterIndex) {
+  // The atom index should invert atom_indices.
+  ASSERT_EQ(struc_desc.atom_clusters.size(), struc_desc.n_atoms);
+  for (int s = 0; s < struc_desc.n_types; s++) {
+    for (int i = 0; i < struc_desc.n_clusters_by_type[s]; i++) {
+      int atom = struc_desc.atom_indices[s](i);
+      int cluster = struc_desc.cumulative_type_count[s] + i;
+      EXPECT_EQ(struc_desc.atom_clusters[atom], cluster);
+      EXPECT_EQ(struc_desc.cluster_type(cluster), s);
+      EXPECT_EQ(struc_desc.cluster_atom(cluster), atom);
+    }
+  }
+
+  // Descriptors without an index give the same clusters.
+  std::vector<int> atoms{3, 0, 3, -1, struc_desc.n_atoms};
+  DescriptorValues unindexed = struc_desc;
+  unindexed.atom_clusters.clear();
+  std::vector<int> clusters = struc_desc.clusters_of_atoms(atoms);
+  EXPECT_EQ(clusters, unindexed.clusters_of_atoms(atoms));
+  ASSERT_EQ(clusters.size(), 3);
+  EXPECT_EQ(clusters[0], struc_desc.atom_clusters[3]);
+  EXPECT_EQ(clusters[1], struc_desc.atom_clusters[0]);
+  EXPECT_EQ(clusters[2], struc_desc.atom_clusters[3]);
+}
+
+TEST_F(StructureTest, BatchMatchesSerial) {
+  std::vector<Eigen::MatrixXd> cells{cell, cell_2, cell_3};
+  std::vector<std::vector<int>> species_list{species, species_2, species_3};
+  std::vector<Eigen::MatrixXd> positions_list{positions, positions_2,
+                                              positions_3};
+  std::vector<Structure> batch = Structure::build_batch(
+      cells, species_list, positions_list, cutoff, dc);
+
+  std::vector<Structure *> serial{&test_struc, &test_struc_2, &test_struc_3};
+  ASSERT_EQ(batch.size(), serial.size());
+  for (int i = 0; i < batch.size(); i++) {
+    EXPECT_EQ(batch[i].neighbor_count, serial[i]->neighbor_count);
+    EXPECT_EQ(batch[i].structure_indices, serial[i]->structure_indices);
+    ASSERT_EQ(batch[i].descriptors.size(), serial[i]->descriptors.size());
+    for (int j = 0; j < batch[i].descriptors.size(); j++) {
+      const DescriptorValues &d1 = batch[i].descriptors[j];
+      const DescriptorValues &d2 = serial[i]->descriptors[j];
+      EXPECT_EQ(d1.n_clusters_by_type, d2.n_clusters_by_type);
+      EXPECT_EQ(d1.atom_clusters, d2.atom_clusters);
+      for (int s = 0; s < d1.n_types; s++) {
+        EXPECT_EQ(d1.descriptors[s], d2.descriptors[s]);
+        EXPECT_EQ(d1.descriptor_force_dervs[s], d2.descriptor_force_dervs[s]);
+      }
+    }
+  }
+
+  EXPECT_THROW(Structure::build_batch(cells, species_list, {positions},
+                                      cutoff, dc),
+               std::invalid_argument);
+}
+
+// Descriptor calculator that fails on structures with a given number of
+// atoms.
+class FailingDescriptor : public Descriptor {
+public:
+  int failing_noa;
+  FailingDescriptor(int failing_noa) : failing_noa(failing_noa) {}
+
+  DescriptorValues compute_struc(Structure &structure) {
+    if (structure.noa == failing_noa)
+      throw std::runtime_error("Descriptor failed.");
+    DescriptorValues desc;
+    desc.n_atoms = structure.noa;
+    desc.n_types = 0;
+    return desc;
+  }
+
+  nlohmann::json return_json() { return nlohmann::json(); }
+};
+
+TEST_F(StructureTest, BatchRethrowsFrameErrors) {
+  // An error in one frame is rethrown by build_batch, and the nesting limit
+  // set for the batch is restored.
+  FailingDescriptor failing(n_atoms - 1);
+  std::vector<Descriptor *> failing_dc{&failing};
+
+  int n_frames = 64;
+  std::vector<Eigen::MatrixXd> cells(n_frames, cell);
+  std::vector<std::vector<int>> species_list(n_frames, species);
+  std::vector<Eigen::MatrixXd> positions_list(n_frames, positions);
+  species_list[n_frames / 2].pop_back();
+  positions_list[n_frames / 2].conservativeResize(n_atoms - 1, 3);
+
+#ifdef _OPENMP
+  int max_levels = omp_get_max_active_levels();
+#endif
+  EXPECT_THROW(Structure::build_batch(cells, species_list, positions_list,
+                                      cutoff, failing_dc),
+               std::runtime_error);
+#ifdef _OPENMP
+  EXPECT_EQ(omp_get_max_active_levels(), max_levels);
+#endif
+
+  species_list[n_frames / 2] = species;
+  positions_list[n_frames / 2] = positions;
+  std::vector<Structure> batch = Structure::build_batch(
+      cells, species_list, positions_list, cutoff, failing_dc);
+  EXPECT_EQ(batch.size(), n_frames);
+}
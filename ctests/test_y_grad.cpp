@@ -274,3 +274,51 @@ TEST_F(YGradTest, AdditionTest) {
     count += m_no;
   }
 }
+
+TEST(YBatch, HighDegree) {
+  // Check gradients and the addition theorem beyond the degrees that were
+  // previously tabulated, and that batches match single evaluations.
+  int l = 14;
+  int sz = (l + 1) * (l + 1);
+  int n = 11;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(n, -3.2, 2.7);
+  Eigen::VectorXd y = Eigen::VectorXd::LinSpaced(n, 1.9, -2.4);
+  Eigen::VectorXd z = Eigen::VectorXd::LinSpaced(n, 0.7, 3.3);
+
+  Eigen::MatrixXd Y, Yx, Yy, Yz;
+  get_Y_batch(Y, Yx, Yy, Yz, x, y, z, l);
+
+  vector<double> Y1(sz), Y2(sz), Y3(sz), Y4(sz);
+  vector<double> Y5(sz), Y6(sz), Y7(sz), Y8(sz);
+  double delta = 1e-7;
+  for (int i = 0; i < n; i++) {
+    get_Y(Y1, Y2, Y3, Y4, x(i), y(i), z(i), l);
+    for (int j = 0; j < sz; j++) {
+      EXPECT_EQ(Y(i, j), Y1[j]);
+      EXPECT_EQ(Yz(i, j), Y4[j]);
+    }
+
+    // The sum over m of Y_lm^2 is (2l + 1) / (4 pi).
+    int count = 0;
+    for (int l_val = 0; l_val < l + 1; l_val++) {
+      double sum = 0;
+      for (int m = 0; m < 2 * l_val + 1; m++) {
+        sum += Y1[count] * Y1[count];
+        count++;
+      }
+      EXPECT_NEAR(sum, (2 * l_val + 1) / (4 * M_PI), 1e-10);
+    }
+
+    // Check the x and z derivatives with central differences.
+    get_Y(Y5, Y6, Y7, Y8, x(i) + delta, y(i), z(i), l);
+    get_Y(Y1, Y6, Y7, Y8, x(i) - delta, y(i), z(i), l);
+    for (int j = 0; j < sz; j++) {
+      EXPECT_NEAR((Y5[j] - Y1[j]) / (2 * delta), Yx(i, j), 1e-6);
+    }
+    get_Y(Y5, Y6, Y7, Y8, x(i), y(i), z(i) + delta, l);
+    get_Y(Y1, Y6, Y7, Y8, x(i), y(i), z(i) - delta, l);
+    for (int j = 0; j < sz; j++) {
+      EXPECT_NEAR((Y5[j] - Y1[j]) / (2 * delta), Yz(i, j), 1e-6);
+    }
+  }
+}
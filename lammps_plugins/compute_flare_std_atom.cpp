@@ -126,13 +126,12 @@ void ComputeFlareStdAtom::compute_peratom() {
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
-  int beta_init, beta_counter;
-  double B2_norm_squared, B2_val_1, B2_val_2;
-
-  Eigen::VectorXd single_bond_vals, B2_vals, B2_env_dot, beta_p, partial_forces, u;
-  Eigen::MatrixXd single_bond_env_dervs, B2_env_dervs;
+  double B2_norm_squared;
   double empty_thresh = 1e-8;
 
+  DescriptorWorkspace workspace;
+  const Eigen::VectorXd &B2_vals = workspace.B2_vals;
+
   #pragma omp for
   for (int ii = 0; ii < inum; ii++) {
     int i = ilist[ii];
@@ -162,14 +161,11 @@ void ComputeFlareStdAtom::compute_peratom() {
 
     // Compute covariant descriptors.
     single_bond_multiple_cutoffs(x, type, jnum, n_inner, i, xtmp, ytmp, ztmp,
-                                 jlist, basis_function, cutoff_function,
-                                 n_species, n_max, l_max, radial_hyps,
-                                 cutoff_hyps, single_bond_vals,
-                                 single_bond_env_dervs, cutoff_matrix);
+                                 jlist, radial_tables, n_species, n_max, l_max,
+                                 cutoff_matrix, workspace);
 
     // Compute invariant descriptors.
-    B2_descriptor(B2_vals, B2_norm_squared,
-                  single_bond_vals, n_species, n_max, l_max);
+    B2_descriptor(workspace, B2_norm_squared, n_species, n_max, l_max);
 
     double variance = 0.0;
     double sig = hyperparameters(0);
@@ -181,8 +177,8 @@ void ComputeFlareStdAtom::compute_peratom() {
 
     if (use_map) {
       int power = 2;
-      compute_energy_and_u(B2_vals, B2_norm_squared, single_bond_vals, power,
-              n_species, n_max, l_max, beta_matrices[itype - 1], u, &variance, normalized);
+      compute_energy_and_u(workspace, B2_norm_squared, power, n_species, n_max,
+              l_max, beta_matrices[itype - 1], &variance, normalized);
       variance /= sig2;
     } else {
       Eigen::VectorXd kernel_vec = Eigen::VectorXd::Zero(n_clusters);
@@ -434,6 +430,12 @@ void ComputeFlareStdAtom::read_file(char *filename) {
   else if (!strcmp(cutoff_string, "cosine"))
     cutoff_function = cos_cutoff;
 
+  // Tabulate the radial basis for each pair of species.
+  radial_tables =
+      build_radial_tables(basis_function, cutoff_function, radial_string,
+                          n_species, n_max, radial_hyps, cutoff_hyps,
+                          cutoff_matrix);
+
   // Set the kernel
   if (!strcmp(kernel_string, "NormalizedDotProduct")) {
     normalized = true;
@@ -569,6 +571,12 @@ void ComputeFlareStdAtom::read_L_inverse(char *filename) {
   else if (!strcmp(cutoff_string, "cosine"))
     cutoff_function = cos_cutoff;
 
+  // Tabulate the radial basis for each pair of species.
+  radial_tables =
+      build_radial_tables(basis_function, cutoff_function, radial_string,
+                          n_species, n_max, radial_hyps, cutoff_hyps,
+                          cutoff_matrix);
+
   // Set the kernel
   if (!strcmp(kernel_string, "NormalizedDotProduct")) {
     normalized = true;
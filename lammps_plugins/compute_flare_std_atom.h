@@ -12,6 +12,7 @@ ComputeStyle(flare/std/atom, ComputeFlareStdAtom)
 #define LMP_COMPUTE_FLARE_STD_ATOM_H
 
 #include "compute.h"
+#include "radial.h"
 #include <Eigen/Dense>
 #include <cstdio>
 #include <vector>
@@ -46,6 +47,7 @@ protected:
       cutoff_function;
 
   std::vector<double> radial_hyps, cutoff_hyps;
+  std::vector<RadialTable> radial_tables;
 
   int nmax; // number of atoms
   double cutoff;
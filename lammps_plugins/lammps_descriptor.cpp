@@ -4,32 +4,62 @@
 #include <cmath>
 #include <iostream>
 
-void single_bond_multiple_cutoffs(
-    double **x, int *type, int jnum, int n_inner, int i, double xtmp,
-    double ytmp, double ztmp, int *jlist,
-    std::function<void(std::vector<double> &, std::vector<double> &, double,
-                       int, std::vector<double>)>
-        basis_function,
-    std::function<void(std::vector<double> &, double, double,
-                       std::vector<double>)>
-        cutoff_function,
-    int n_species, int N, int lmax,
-    const std::vector<double> &radial_hyps,
-    const std::vector<double> &cutoff_hyps, Eigen::VectorXd &single_bond_vals,
-    Eigen::MatrixXd &single_bond_env_dervs,
-    const Eigen::MatrixXd &cutoff_matrix) {
+void DescriptorWorkspace::resize(int n_species, int N, int lmax,
+                                 int max_neighbors) {
+  int n_harmonics = (lmax + 1) * (lmax + 1);
+  int n_radial = n_species * N;
+  int n_bond = n_radial * n_harmonics;
+  int n_descriptors = (n_radial * (n_radial + 1) / 2) * (lmax + 1);
 
-  // Initialize basis vectors and spherical harmonics.
-  std::vector<double> g = std::vector<double>(N, 0);
-  std::vector<double> gx = std::vector<double>(N, 0);
-  std::vector<double> gy = std::vector<double>(N, 0);
-  std::vector<double> gz = std::vector<double>(N, 0);
+  if (n_species != this->n_species || N != this->N || lmax != this->lmax) {
+    this->n_species = n_species;
+    this->N = N;
+    this->lmax = lmax;
+    g.assign(N, 0);
+    gx.assign(N, 0);
+    gy.assign(N, 0);
+    gz.assign(N, 0);
+    h.assign(n_harmonics, 0);
+    hx.assign(n_harmonics, 0);
+    hy.assign(n_harmonics, 0);
+    hz.assign(n_harmonics, 0);
+    single_bond_vals.resize(n_bond);
+    u.resize(n_bond);
+    B2_vals.resize(n_descriptors);
+    beta_p.resize(n_descriptors);
+    w.resize(n_descriptors);
+    this->max_neighbors = 0;
+  }
+
+  if (max_neighbors > this->max_neighbors) {
+    this->max_neighbors = max_neighbors;
+    single_bond_env_dervs.resize(3 * max_neighbors, n_bond);
+  }
+}
 
+// Accumulate the single bond basis of atom i in workspace.single_bond_vals
+// and the first 3 * n_inner rows of workspace.single_bond_env_dervs. The
+// radial part of each bond is computed by
+// radial(g, gx, gy, gz, delx, dely, delz, r, cutoff, s), where s is the
+// species of the neighbor.
+template <typename RadialFunction>
+static void single_bond_loop(double **x, int *type, int jnum, int n_inner,
+                             int i, double xtmp, double ytmp, double ztmp,
+                             int *jlist, int n_species, int N, int lmax,
+                             const Eigen::MatrixXd &cutoff_matrix,
+                             DescriptorWorkspace &workspace,
+                             RadialFunction radial) {
+
+  // The workspace only reallocates if the settings change or if atom i has
+  // more neighbors than any atom seen before.
+  workspace.resize(n_species, N, lmax, n_inner);
+  std::vector<double> &g = workspace.g, &gx = workspace.gx,
+                      &gy = workspace.gy, &gz = workspace.gz;
+  std::vector<double> &h = workspace.h, &hx = workspace.hx,
+                      &hy = workspace.hy, &hz = workspace.hz;
+  Eigen::VectorXd &single_bond_vals = workspace.single_bond_vals;
+  Eigen::MatrixXd &single_bond_env_dervs = workspace.single_bond_env_dervs;
   int n_harmonics = (lmax + 1) * (lmax + 1);
-  std::vector<double> h = std::vector<double>(n_harmonics, 0);
-  std::vector<double> hx = std::vector<double>(n_harmonics, 0);
-  std::vector<double> hy = std::vector<double>(n_harmonics, 0);
-  std::vector<double> hz = std::vector<double>(n_harmonics, 0);
 
   // Prepare LAMMPS variables.
   int central_species = type[i] - 1;
@@ -38,13 +68,8 @@ void single_bond_multiple_cutoffs(
   int j, s, descriptor_counter;
 
   // Initialize vectors.
-  int n_radial = n_species * N;
-  int n_bond = n_radial * n_harmonics;
-  single_bond_vals = Eigen::VectorXd::Zero(n_bond);
-  single_bond_env_dervs = Eigen::MatrixXd::Zero(n_inner * 3, n_bond);
-
-  // Initialize radial hyperparameters.
-  std::vector<double> new_radial_hyps = radial_hyps;
+  single_bond_vals.setZero();
+  single_bond_env_dervs.topRows(n_inner * 3).setZero();
 
   // Loop over neighbors.
   int n_count = 0;
@@ -63,11 +88,7 @@ void single_bond_multiple_cutoffs(
     double cutforcesq = cutoff * cutoff;
 
     if (rsq < cutforcesq) { // minus a small value to prevent numerial error
-      // Reset endpoint of the radial basis set.
-      new_radial_hyps[1] = cutoff;
-
-      calculate_radial(g, gx, gy, gz, basis_function, cutoff_function, delx,
-                       dely, delz, r, cutoff, N, new_radial_hyps, cutoff_hyps);
+      radial(g, gx, gy, gz, delx, dely, delz, r, cutoff, s);
       get_Y(h, hx, hy, hz, delx, dely, delz, lmax);
 
       // Store the products and their derivatives.
@@ -106,6 +127,89 @@ void single_bond_multiple_cutoffs(
   }
 }
 
+void single_bond_multiple_cutoffs(
+    double **x, int *type, int jnum, int n_inner, int i, double xtmp,
+    double ytmp, double ztmp, int *jlist,
+    std::function<void(std::vector<double> &, std::vector<double> &, double,
+                       int, std::vector<double>)>
+        basis_function,
+    std::function<void(std::vector<double> &, double, double,
+                       std::vector<double>)>
+        cutoff_function,
+    int n_species, int N, int lmax,
+    const std::vector<double> &radial_hyps,
+    const std::vector<double> &cutoff_hyps, Eigen::VectorXd &single_bond_vals,
+    Eigen::MatrixXd &single_bond_env_dervs,
+    const Eigen::MatrixXd &cutoff_matrix) {
+
+  // Initialize radial hyperparameters.
+  std::vector<double> new_radial_hyps = radial_hyps;
+
+  DescriptorWorkspace workspace;
+  single_bond_loop(
+      x, type, jnum, n_inner, i, xtmp, ytmp, ztmp, jlist, n_species, N, lmax,
+      cutoff_matrix, workspace,
+      [&](std::vector<double> &g, std::vector<double> &gx,
+          std::vector<double> &gy, std::vector<double> &gz, double delx,
+          double dely, double delz, double r, double cutoff, int s) {
+        // Reset endpoint of the radial basis set.
+        new_radial_hyps[1] = cutoff;
+        calculate_radial(g, gx, gy, gz, basis_function, cutoff_function, delx,
+                         dely, delz, r, cutoff, N, new_radial_hyps,
+                         cutoff_hyps);
+      });
+
+  single_bond_vals = workspace.single_bond_vals;
+  single_bond_env_dervs = workspace.single_bond_env_dervs.topRows(n_inner * 3);
+}
+
+void single_bond_multiple_cutoffs(
+    double **x, int *type, int jnum, int n_inner, int i, double xtmp,
+    double ytmp, double ztmp, int *jlist,
+    const std::vector<RadialTable> &radial_tables, int n_species, int N,
+    int lmax, const Eigen::MatrixXd &cutoff_matrix,
+    DescriptorWorkspace &workspace) {
+
+  int central_species = type[i] - 1;
+  single_bond_loop(
+      x, type, jnum, n_inner, i, xtmp, ytmp, ztmp, jlist, n_species, N, lmax,
+      cutoff_matrix, workspace,
+      [&](std::vector<double> &g, std::vector<double> &gx,
+          std::vector<double> &gy, std::vector<double> &gz, double delx,
+          double dely, double delz, double r, double cutoff, int s) {
+        radial_tables[central_species * n_species + s].calculate_radial(
+            g.data(), gx.data(), gy.data(), gz.data(), delx, dely, delz, r);
+      });
+}
+
+std::vector<RadialTable> build_radial_tables(
+    std::function<void(std::vector<double> &, std::vector<double> &, double,
+                       int, std::vector<double>)>
+        basis_function,
+    std::function<void(std::vector<double> &, double, double,
+                       std::vector<double>)>
+        cutoff_function,
+    const std::string &radial_basis, int n_species, int N,
+    const std::vector<double> &radial_hyps,
+    const std::vector<double> &cutoff_hyps,
+    const Eigen::MatrixXd &cutoff_matrix) {
+
+  // The tables start where B2 starts them in training.
+  double r_min = radial_basis_min(radial_basis, radial_hyps);
+  std::vector<RadialTable> radial_tables;
+  std::vector<double> new_radial_hyps = radial_hyps;
+  for (int i = 0; i < n_species; i++) {
+    for (int j = 0; j < n_species; j++) {
+      double cutoff = cutoff_matrix(i, j);
+      new_radial_hyps[1] = cutoff;
+      radial_tables.push_back(RadialTable(basis_function, cutoff_function,
+                                          r_min, cutoff, N,
+                                          new_radial_hyps, cutoff_hyps));
+    }
+  }
+  return radial_tables;
+}
+
 void single_bond(
     double **x, int *type, int jnum, int n_inner, int i, double xtmp,
     double ytmp, double ztmp, int *jlist,
@@ -206,12 +310,14 @@ void single_bond(
   */
 }
 
-void B2_descriptor(Eigen::VectorXd &B2_vals, 
+void B2_descriptor(DescriptorWorkspace &workspace,
                    double &norm_squared,
-                   const Eigen::VectorXd &single_bond_vals,
                    int n_species,
                    int N, int lmax) { 
 
+  Eigen::VectorXd &B2_vals = workspace.B2_vals;
+  const Eigen::VectorXd &single_bond_vals = workspace.single_bond_vals;
+
   int n_radial = n_species * N;
   int n_harmonics = (lmax + 1) * (lmax + 1);
   int n_descriptors = (n_radial * (n_radial + 1) / 2) * (lmax + 1);
@@ -219,7 +325,7 @@ void B2_descriptor(Eigen::VectorXd &B2_vals,
   int n1_l, n2_l, counter, n1_count, n2_count;
 
   // Zero the B2 vectors and matrices.
-  B2_vals = Eigen::VectorXd::Zero(n_descriptors);
+  B2_vals.setZero(n_descriptors);
 
   // Compute the descriptor.
   for (int n1 = n_radial - 1; n1 >= 0; n1--) {
@@ -247,25 +353,27 @@ void B2_descriptor(Eigen::VectorXd &B2_vals,
   norm_squared = B2_vals.dot(B2_vals);
 }
 
-void compute_energy_and_u(Eigen::VectorXd &B2_vals, 
-                   double &norm_squared,
-                   const Eigen::VectorXd &single_bond_vals,
+void compute_energy_and_u(DescriptorWorkspace &workspace,
+                   double norm_squared,
                    int power, int n_species,
                    int N, int lmax, const Eigen::MatrixXd &beta_matrix, 
-                   Eigen::VectorXd &u, double *evdwl, bool normalized) {
+                   double *evdwl, bool normalized) {
 
   int n1_l, n2_l, counter, n1_count, n2_count;
   int n_radial = n_species * N;
   int n_harmonics = (lmax + 1) * (lmax + 1);
 
-  Eigen::VectorXd w;
+  const Eigen::VectorXd &B2_vals = workspace.B2_vals;
+  const Eigen::VectorXd &single_bond_vals = workspace.single_bond_vals;
+  Eigen::VectorXd &w = workspace.w, &beta_p = workspace.beta_p,
+                  &u = workspace.u;
   if (normalized) {
     if (power == 1) {
       double B2_norm = pow(norm_squared, 0.5);
       *evdwl = B2_vals.dot(beta_matrix.col(0)) / B2_norm;
       w = beta_matrix.col(0) / B2_norm - *evdwl * B2_vals / norm_squared;
     } else if (power == 2) { 
-      Eigen::VectorXd beta_p = beta_matrix * B2_vals;
+      beta_p.noalias() = beta_matrix * B2_vals;
       *evdwl = B2_vals.dot(beta_p) / norm_squared;
       w = 2 * (beta_p - *evdwl * B2_vals) / norm_squared;
     }
@@ -274,14 +382,14 @@ void compute_energy_and_u(Eigen::VectorXd &B2_vals,
       w = beta_matrix.col(0);
       *evdwl = B2_vals.dot(w);
     } else if (power == 2) { 
-      Eigen::VectorXd beta_p = beta_matrix * B2_vals;
+      beta_p.noalias() = beta_matrix * B2_vals;
       *evdwl = B2_vals.dot(beta_p);
       w = 2 * beta_p;
     }
   }
 
   // Compute u(n1, l, m), where f_ik = u * dA/dr_ik
-  u = Eigen::VectorXd::Zero(single_bond_vals.size());
+  u.setZero(single_bond_vals.size());
   double factor;
   for (int n1 = n_radial - 1; n1 >= 0; n1--) {
     for (int n2 = 0; n2 < n_radial; n2++) {
@@ -1,10 +1,26 @@
 #ifndef LAMMPS_DESCRIPTOR_H
 #define LAMMPS_DESCRIPTOR_H
 
+#include "radial.h"
 #include <Eigen/Dense>
 #include <functional>
 #include <vector>
 
+// Scratch arrays for the descriptor of one atom. They are reused from atom
+// to atom, so that evaluating descriptors, energies and forces does not
+// allocate in the MD loop. single_bond_env_dervs has room for
+// max_neighbors neighbors, of which only the first 3 * n_inner rows are
+// used for a given atom.
+struct DescriptorWorkspace {
+  int n_species = 0, N = 0, lmax = 0, max_neighbors = 0;
+  std::vector<double> g, gx, gy, gz, h, hx, hy, hz;
+  Eigen::VectorXd single_bond_vals, B2_vals, beta_p, w, u;
+  Eigen::MatrixXd single_bond_env_dervs;
+
+  // Reallocate only if the descriptor settings change or max_neighbors
+  // exceeds the current capacity.
+  void resize(int n_species, int N, int lmax, int max_neighbors);
+};
 
 void single_bond(
     double **x, int *type, int jnum, int n_inner, int i, double xtmp,
@@ -35,17 +51,43 @@ void single_bond_multiple_cutoffs(
     Eigen::MatrixXd &single_bond_env_dervs,
     const Eigen::MatrixXd &cutoff_matrix);
 
-void B2_descriptor(Eigen::VectorXd &B2_vals,
+// Same as above, with the radial basis evaluated from spline tables built by
+// build_radial_tables. The result is stored in workspace.single_bond_vals and
+// the first 3 * n_inner rows of workspace.single_bond_env_dervs.
+void single_bond_multiple_cutoffs(
+    double **x, int *type, int jnum, int n_inner, int i, double xtmp,
+    double ytmp, double ztmp, int *jlist,
+    const std::vector<RadialTable> &radial_tables, int n_species, int N,
+    int lmax, const Eigen::MatrixXd &cutoff_matrix,
+    DescriptorWorkspace &workspace);
+
+// Tabulate the radial basis for each pair of species, indexed by
+// central species * n_species + neighbor species. radial_basis is the name
+// of basis_function, which sets where the tables start (see
+// radial_basis_min).
+std::vector<RadialTable> build_radial_tables(
+    std::function<void(std::vector<double> &, std::vector<double> &, double,
+                       int, std::vector<double>)>
+        basis_function,
+    std::function<void(std::vector<double> &, double, double,
+                       std::vector<double>)>
+        cutoff_function,
+    const std::string &radial_basis, int n_species, int N,
+    const std::vector<double> &radial_hyps,
+    const std::vector<double> &cutoff_hyps,
+    const Eigen::MatrixXd &cutoff_matrix);
+
+// Compute workspace.B2_vals from workspace.single_bond_vals.
+void B2_descriptor(DescriptorWorkspace &workspace,
                    double &norm_squared,
-                   const Eigen::VectorXd &single_bond_vals,
                    int n_species,
                    int N, int lmax);
 
-void compute_energy_and_u(Eigen::VectorXd &B2_vals, 
-                   double &norm_squared,
-                   const Eigen::VectorXd &single_bond_vals,
+// Compute the local energy and workspace.u from workspace.B2_vals.
+void compute_energy_and_u(DescriptorWorkspace &workspace,
+                   double norm_squared,
                    int power, int n_species,
                    int N, int lmax, const Eigen::MatrixXd &beta_matrix, 
-                   Eigen::VectorXd &u, double *evdwl, bool normalized);
+                   double *evdwl, bool normalized);
 
 #endif
@@ -8,6 +8,7 @@
 #include "neigh_request.h"
 #include "neighbor.h"
 #include <Eigen/Dense>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -86,12 +87,19 @@ void PairFLARE::compute(int eflag, int vflag) {
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
-  int beta_init, beta_counter;
-  double B2_norm_squared, B2_val_1, B2_val_2;
-  Eigen::VectorXd single_bond_vals, B2_vals, B2_env_dot, u;
-  Eigen::MatrixXd single_bond_env_dervs, B2_env_dervs;
+  double B2_norm_squared;
   double empty_thresh = 1e-8;
 
+  // Size the workspace for the largest neighbor list, so that the loop
+  // below does not allocate.
+  int max_neighbors = 0;
+  for (ii = 0; ii < inum; ii++)
+    max_neighbors = std::max(max_neighbors, numneigh[ilist[ii]]);
+  workspace.resize(n_species, n_max, l_max, max_neighbors);
+  const Eigen::MatrixXd &single_bond_env_dervs =
+      workspace.single_bond_env_dervs;
+  const Eigen::VectorXd &u = workspace.u;
+
   for (ii = 0; ii < inum; ii++) {
     i = list->ilist[ii];
     itype = type[i];
@@ -119,17 +127,14 @@ void PairFLARE::compute(int eflag, int vflag) {
     // Compute covariant descriptors.
     double secs;
     single_bond_multiple_cutoffs(x, type, jnum, n_inner, i, xtmp, ytmp, ztmp,
-                                 jlist, basis_function, cutoff_function,
-                                 n_species, n_max, l_max, radial_hyps,
-                                 cutoff_hyps, single_bond_vals,
-                                 single_bond_env_dervs, cutoff_matrix);
+                                 jlist, radial_tables, n_species, n_max, l_max,
+                                 cutoff_matrix, workspace);
 
     // Compute invariant descriptors.
-    B2_descriptor(B2_vals, B2_norm_squared,
-                  single_bond_vals, n_species, n_max, l_max);
+    B2_descriptor(workspace, B2_norm_squared, n_species, n_max, l_max);
 
-    compute_energy_and_u(B2_vals, B2_norm_squared, single_bond_vals, power,
-           n_species, n_max, l_max, beta_matrices[itype - 1], u, &evdwl, normalized);
+    compute_energy_and_u(workspace, B2_norm_squared, power, n_species, n_max,
+           l_max, beta_matrices[itype - 1], &evdwl, normalized);
 
     // Continue if the environment is empty.
     if (B2_norm_squared < empty_thresh)
@@ -357,6 +362,12 @@ void PairFLARE::read_file(char *filename) {
   else if (!strcmp(cutoff_string, "cosine"))
     cutoff_function = cos_cutoff;
 
+  // Tabulate the radial basis for each pair of species.
+  radial_tables =
+      build_radial_tables(basis_function, cutoff_function, radial_string,
+                          n_species, n_max, radial_hyps, cutoff_hyps,
+                          cutoff_matrix);
+
   // Set the kernel
   if (strcmp(kernel_string, "NormalizedDotProduct") == 0) {
     normalized = true;
@@ -10,7 +10,9 @@ PairStyle(flare, PairFLARE)
 #ifndef LMP_PAIR_FLARE_H
 #define LMP_PAIR_FLARE_H
 
+#include "lammps_descriptor.h"
 #include "pair.h"
+#include "radial.h"
 #include <Eigen/Dense>
 #include <cstdio>
 #include <vector>
@@ -39,6 +41,8 @@ protected:
       cutoff_function;
 
   std::vector<double> radial_hyps, cutoff_hyps;
+  std::vector<RadialTable> radial_tables;
+  DescriptorWorkspace workspace;
 
   double cutoff;
   double *beta, *cutoffs;
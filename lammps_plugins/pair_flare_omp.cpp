@@ -0,0 +1,203 @@
+#include "pair_flare_omp.h"
+#include "atom.h"
+#include "comm.h"
+#include "force.h"
+#include "neigh_list.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// flare++ modules
+#include "lammps_descriptor.h"
+
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairFLAREOMP::PairFLAREOMP(LAMMPS *lmp) : PairFLARE(lmp) {}
+
+/* ----------------------------------------------------------------------
+   Same as PairFLARE::compute, with the loop over local atoms split across
+   comm->nthreads OpenMP threads. Each thread accumulates forces, energies
+   and virials in private buffers, which are summed in thread order once
+   all atoms have been processed.
+------------------------------------------------------------------------- */
+
+void PairFLAREOMP::compute(int eflag, int vflag) {
+  ev_init(eflag, vflag);
+
+  double **x = atom->x;
+  double **f = atom->f;
+  int *type = atom->type;
+  int nlocal = atom->nlocal;
+  int nall = nlocal + atom->nghost;
+
+  int inum = list->inum;
+  int *ilist = list->ilist;
+  int *numneigh = list->numneigh;
+  int **firstneigh = list->firstneigh;
+
+  int nthreads = comm->nthreads;
+  thread_forces.assign((size_t)nthreads * nall * 3, 0.0);
+  if (vflag_atom)
+    thread_vatom.assign((size_t)nthreads * nall * 6, 0.0);
+
+  // One descriptor workspace per thread, sized for the largest neighbor
+  // list.
+  int max_neighbors = 0;
+  for (int ii = 0; ii < inum; ii++)
+    max_neighbors = std::max(max_neighbors, numneigh[ilist[ii]]);
+  if (workspaces.size() < nthreads)
+    workspaces.resize(nthreads);
+
+  double energy_sum = 0.0;
+  double virial_sum[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+#pragma omp parallel num_threads(nthreads)
+{
+#ifdef _OPENMP
+  int tid = omp_get_thread_num();
+#else
+  int tid = 0;
+#endif
+  double *ft = &thread_forces[(size_t)tid * nall * 3];
+  double *vt = vflag_atom ? &thread_vatom[(size_t)tid * nall * 6] : nullptr;
+
+  double delx, dely, delz, xtmp, ytmp, ztmp, rsq;
+  double B2_norm_squared;
+  double empty_thresh = 1e-8;
+
+  DescriptorWorkspace &workspace = workspaces[tid];
+  workspace.resize(n_species, n_max, l_max, max_neighbors);
+  const Eigen::MatrixXd &single_bond_env_dervs =
+      workspace.single_bond_env_dervs;
+  const Eigen::VectorXd &u = workspace.u;
+
+  double energy_thread = 0.0;
+  double virial_thread[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+  #pragma omp for schedule(dynamic, 16)
+  for (int ii = 0; ii < inum; ii++) {
+    int i = ilist[ii];
+    int itype = type[i];
+    int jnum = numneigh[i];
+    xtmp = x[i][0];
+    ytmp = x[i][1];
+    ztmp = x[i][2];
+    int *jlist = firstneigh[i];
+
+    // Count the atoms inside the cutoff.
+    int n_inner = 0;
+    for (int jj = 0; jj < jnum; jj++) {
+      int j = jlist[jj];
+      int s = type[j] - 1;
+      double cutoff_val = cutoff_matrix(itype-1, s);
+
+      delx = x[j][0] - xtmp;
+      dely = x[j][1] - ytmp;
+      delz = x[j][2] - ztmp;
+      rsq = delx * delx + dely * dely + delz * delz;
+      if (rsq < (cutoff_val * cutoff_val))
+        n_inner++;
+    }
+
+    // Compute covariant descriptors.
+    single_bond_multiple_cutoffs(x, type, jnum, n_inner, i, xtmp, ytmp, ztmp,
+                                 jlist, radial_tables, n_species, n_max, l_max,
+                                 cutoff_matrix, workspace);
+
+    // Compute invariant descriptors.
+    double evdwl = 0.0;
+    B2_descriptor(workspace, B2_norm_squared, n_species, n_max, l_max);
+
+    compute_energy_and_u(workspace, B2_norm_squared, power, n_species, n_max,
+           l_max, beta_matrices[itype - 1], &evdwl, normalized);
+
+    // Continue if the environment is empty.
+    if (B2_norm_squared < empty_thresh)
+      continue;
+
+    // Update force and virial buffers.
+    int n_count = 0;
+    for (int jj = 0; jj < jnum; jj++) {
+      int j = jlist[jj];
+      int s = type[j] - 1;
+      double cutoff_val = cutoff_matrix(itype-1, s);
+      delx = xtmp - x[j][0];
+      dely = ytmp - x[j][1];
+      delz = ztmp - x[j][2];
+      rsq = delx * delx + dely * dely + delz * delz;
+
+      if (rsq < (cutoff_val * cutoff_val)) {
+        // Compute partial force f_ij = u * dA/dr_ij
+        double fx = single_bond_env_dervs.row(n_count * 3).dot(u);
+        double fy = single_bond_env_dervs.row(n_count * 3 + 1).dot(u);
+        double fz = single_bond_env_dervs.row(n_count * 3 + 2).dot(u);
+
+        ft[3 * i] += fx;
+        ft[3 * i + 1] += fy;
+        ft[3 * i + 2] += fz;
+        ft[3 * j] -= fx;
+        ft[3 * j + 1] -= fy;
+        ft[3 * j + 2] -= fz;
+
+        // Equivalent of ev_tally_xyz with newton_pair on, which the pair
+        // style requires.
+        if (vflag_either) {
+          double v[6] = {delx * fx, dely * fy, delz * fz,
+                         delx * fy, delx * fz, dely * fz};
+          if (vflag_global)
+            for (int k = 0; k < 6; k++) virial_thread[k] += v[k];
+          if (vflag_atom) {
+            for (int k = 0; k < 6; k++) {
+              vt[6 * i + k] += 0.5 * v[k];
+              vt[6 * j + k] += 0.5 * v[k];
+            }
+          }
+        }
+        n_count++;
+      }
+    }
+
+    // Equivalent of ev_tally_full(i, 2.0 * evdwl, ...). Atom i is only
+    // visited by this thread, so eatom can be updated directly.
+    if (eflag_global)
+      energy_thread += evdwl;
+    if (eflag_atom)
+      eatom[i] += evdwl;
+  }
+
+  #pragma omp critical
+  {
+    energy_sum += energy_thread;
+    for (int k = 0; k < 6; k++) virial_sum[k] += virial_thread[k];
+  }
+
+  // Reduce the thread buffers in thread order.
+  #pragma omp for
+  for (int i = 0; i < nall; i++) {
+    for (int t = 0; t < nthreads; t++) {
+      const double *fs = &thread_forces[((size_t)t * nall + i) * 3];
+      f[i][0] += fs[0];
+      f[i][1] += fs[1];
+      f[i][2] += fs[2];
+      if (vflag_atom) {
+        const double *vs = &thread_vatom[((size_t)t * nall + i) * 6];
+        for (int k = 0; k < 6; k++) vatom[i][k] += vs[k];
+      }
+    }
+  }
+} // #pragma
+
+  if (eflag_global)
+    eng_vdwl += energy_sum;
+  if (vflag_global)
+    for (int k = 0; k < 6; k++) virial[k] += virial_sum[k];
+
+  if (vflag_fdotr)
+    virial_fdotr_compute();
+}
@@ -0,0 +1,33 @@
+// OpenMP-threaded version of pair style flare.
+
+#ifdef PAIR_CLASS
+
+PairStyle(flare/omp, PairFLAREOMP)
+
+#else
+
+#ifndef LMP_PAIR_FLARE_OMP_H
+#define LMP_PAIR_FLARE_OMP_H
+
+#include "pair_flare.h"
+#include <vector>
+
+namespace LAMMPS_NS {
+
+class PairFLAREOMP : public PairFLARE {
+public:
+  PairFLAREOMP(class LAMMPS *);
+  virtual void compute(int, int);
+
+protected:
+  // Thread-private force and per-atom virial buffers, reduced into the
+  // LAMMPS arrays at the end of each compute call. They are kept between
+  // steps so that they are only reallocated when the number of atoms grows.
+  std::vector<double> thread_forces, thread_vatom;
+  std::vector<DescriptorWorkspace> workspaces;
+};
+
+} // namespace LAMMPS_NS
+
+#endif
+#endif
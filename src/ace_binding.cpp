@@ -49,6 +49,10 @@ PYBIND11_MODULE(_C_flare, m) {
       .def_readwrite("descriptor_calculators",
                     &Structure::descriptor_calculators)
       .def("compute_descriptors", &Structure::compute_descriptors)
+      .def_static("build_batch", &Structure::build_batch, py::arg("cells"),
+                  py::arg("species"), py::arg("positions"), py::arg("cutoff"),
+                  py::arg("descriptor_calculators"),
+                  py::call_guard<py::gil_scoped_release>())
       .def("wrap_positions", &Structure::wrap_positions)
       .def_static("to_json", &Structure::to_json)
       .def_static("from_json", &Structure::from_json);
@@ -175,11 +179,20 @@ PYBIND11_MODULE(_C_flare, m) {
       .def("predict_DTC", &SparseGP::predict_DTC)
       .def("predict_local_uncertainties",
            &SparseGP::predict_local_uncertainties)
+      .def("predict_mean_batch", &SparseGP::predict_mean_batch)
+      .def("predict_SOR_batch", &SparseGP::predict_SOR_batch)
+      .def("predict_DTC_batch", &SparseGP::predict_DTC_batch)
       .def("add_all_environments", &SparseGP::add_all_environments)
       .def("add_specific_environments", &SparseGP::add_specific_environments)
       .def("add_random_environments", &SparseGP::add_random_environments)
       .def("add_uncertain_environments",
-           &SparseGP::add_uncertain_environments)
+           &SparseGP::add_uncertain_environments, py::arg("structure"),
+           py::arg("n_added"), py::arg("diverse") = false)
+      .def("remove_sparse_environments",
+           &SparseGP::remove_sparse_environments, py::arg("removed"))
+      .def("prune_sparse_environments",
+           &SparseGP::prune_sparse_environments,
+           py::arg("min_relative_variance"))
       .def("add_training_structure", &SparseGP::add_training_structure,
                        py::arg("structure"),
                        py::arg("atom_indices") = - Eigen::VectorXi::Ones(1),
@@ -201,6 +214,8 @@ PYBIND11_MODULE(_C_flare, m) {
       .def("write_sparse_descriptors", &SparseGP::write_sparse_descriptors)
       .def("write_L_inverse", &SparseGP::write_L_inverse)
       .def_readwrite("Kuu_jitter", &SparseGP::Kuu_jitter)
+      .def_readwrite("compact_training", &SparseGP::compact_training)
+      .def_readwrite("recompress_training", &SparseGP::recompress_training)
       .def_readonly("complexity_penalty", &SparseGP::complexity_penalty)
       .def_readonly("data_fit", &SparseGP::data_fit)
       .def_readonly("constant_term", &SparseGP::constant_term)
@@ -222,16 +237,35 @@ PYBIND11_MODULE(_C_flare, m) {
       .def_readonly("Kuu", &SparseGP::Kuu)
       .def_readonly("Kuu_kernels", &SparseGP::Kuu_kernels)
       .def_readonly("Kuf", &SparseGP::Kuf)
-      .def_readonly("Kuf_kernels", &SparseGP::Kuf_kernels)
+      .def_property_readonly("Kuf_kernels",
+                             [](const SparseGP &gp) {
+                               std::vector<Eigen::MatrixXd> blocks;
+                               if (gp.Kuf.rows() != gp.n_sparse)
+                                 return blocks;
+                               for (int i = 0; i < gp.n_kernels; i++)
+                                 blocks.push_back(gp.Kuf_kernel(i));
+                               return blocks;
+                             })
       .def_readwrite("Kuf_e_noise_Kfu", &SparseGP::Kuf_e_noise_Kfu)
       .def_readwrite("Kuf_f_noise_Kfu", &SparseGP::Kuf_f_noise_Kfu)
       .def_readwrite("Kuf_s_noise_Kfu", &SparseGP::Kuf_s_noise_Kfu)
       .def_readonly("alpha", &SparseGP::alpha)
-      .def_readonly("Kuu_inverse", &SparseGP::Kuu_inverse)
-      .def_readonly("Sigma", &SparseGP::Sigma)
+      .def_property_readonly("Kuu_inverse",
+                             [](const SparseGP &gp) {
+                               return Eigen::MatrixXd(
+                                   gp.solution_matrix("Kuu_inverse"));
+                             })
+      .def_property_readonly("Sigma",
+                             [](const SparseGP &gp) {
+                               return Eigen::MatrixXd(
+                                   gp.solution_matrix("Sigma"));
+                             })
       .def_readonly("n_sparse", &SparseGP::n_sparse)
       .def_readonly("n_labels", &SparseGP::n_labels)
       .def_readonly("y", &SparseGP::y)
       .def_static("to_json", &SparseGP::to_json)
-      .def_static("from_json", &SparseGP::from_json);
+      .def_static("from_json", &SparseGP::from_json)
+      .def_static("to_binary", &SparseGP::to_binary)
+      .def_static("from_binary", &SparseGP::from_binary,
+                  py::arg("file_name"), py::arg("prediction_only") = false);
 }
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <iostream>
 #include <numeric> // Iota
+#include <stdexcept>
 
 GP ::GP() {}
 
@@ -48,7 +49,6 @@ GP ::GP(std::vector<Kernel *> kernels, double energy_noise, double force_noise,
   }
 }
 
-// TODO: Finish implementing.
 void GP ::add_training_structure(const Structure &structure) {
 
   int n_energy = structure.energy.size();
@@ -57,75 +57,209 @@ void GP ::add_training_structure(const Structure &structure) {
   int n_struc_labels = n_energy + n_force + n_stress;
   int n_atoms = structure.noa;
 
-  // Update Kff kernels.
   for (int i = 0; i < n_kernels; i++) {
-    // Resize Kff matrix.
     Kff_kernels[i].conservativeResize(n_labels + n_struc_labels,
                                       n_labels + n_struc_labels);
+  }
+
+  // Compute kernels between the new structure and each previous structure
+  // (j < n_strucs) and itself (j == n_strucs). Each iteration writes a
+  // disjoint block row and column of the Kff kernels, located with the
+  // cumulative label counts.
+#pragma omp parallel for schedule(dynamic)
+  for (int j = 0; j <= n_strucs; j++) {
+    const Structure &struc_j =
+        (j == n_strucs) ? structure : training_structures[j];
+    int ne_j = struc_j.energy.size();
+    int nf_j = struc_j.forces.size();
+    int ns_j = struc_j.stresses.size();
+    int na_j = struc_j.noa;
+    int row = label_count(j);
+
+    for (int i = 0; i < n_kernels; i++) {
+      Eigen::MatrixXd struc_kernels = kernels[i]->struc_struc(
+          struc_j.descriptors[i], structure.descriptors[i],
+          kernels[i]->kernel_hyperparameters);
+
+      assign_kernels(struc_kernels, Kff_kernels[i], ne_j, nf_j, ns_j, na_j,
+                     n_energy, n_force, n_stress, n_atoms, row, n_labels);
+
+      if (j < n_strucs) {
+        assign_kernels(struc_kernels.transpose(), Kff_kernels[i], n_energy,
+                       n_force, n_stress, n_atoms, ne_j, nf_j, ns_j, na_j,
+                       n_labels, row);
+      }
+    }
+  }
+
+  // Update labels.
+  label_count.conservativeResize(n_strucs + 2);
+  label_count(n_strucs + 1) = n_labels + n_struc_labels;
+  y.conservativeResize(n_labels + n_struc_labels);
+  y.segment(n_labels, n_energy) = structure.energy;
+  y.segment(n_labels + n_energy, n_force) = structure.forces;
+  y.segment(n_labels + n_energy + n_force, n_stress) = structure.stresses;
+
+  // Update noise.
+  noise_vector.conservativeResize(n_labels + n_struc_labels);
+  noise_vector.segment(n_labels, n_energy) =
+      Eigen::VectorXd::Constant(n_energy, 1 / (energy_noise * energy_noise));
+  noise_vector.segment(n_labels + n_energy, n_force) =
+      Eigen::VectorXd::Constant(n_force, 1 / (force_noise * force_noise));
+  noise_vector.segment(n_labels + n_energy + n_force, n_stress) =
+      Eigen::VectorXd::Constant(n_stress, 1 / (stress_noise * stress_noise));
+
+  // Update label count.
+  n_energy_labels += n_energy;
+  n_force_labels += n_force;
+  n_stress_labels += n_stress;
+  n_labels += n_struc_labels;
+
+  // Store training structure.
+  training_structures.push_back(structure);
+  n_strucs += 1;
+}
+
+void GP ::update_matrices() {
+  Kff = Eigen::MatrixXd::Zero(n_labels, n_labels);
+  for (int i = 0; i < n_kernels; i++) {
+    Kff += Kff_kernels[i];
+  }
+
+  // Extend the Cholesky factor to the labels added since the last update.
+  // With K = [K11 K12; K21 K22] and K11 = L11 L11^T, the new rows are
+  // L21 = (L11^-1 K12)^T and L22 = chol(K22 - L21 L21^T).
+  if (n_factored < n_labels) {
+    int n_new = n_labels - n_factored;
+
+    Eigen::MatrixXd K22 = Kff.block(n_factored, n_factored, n_new, n_new);
+    K22.diagonal() +=
+        (1 / noise_vector.segment(n_factored, n_new).array()).matrix();
+
+    Eigen::MatrixXd L21_T = Kff.block(0, n_factored, n_factored, n_new);
+    if (n_factored > 0) {
+      L.triangularView<Eigen::Lower>().solveInPlace(L21_T);
+      K22.selfadjointView<Eigen::Lower>().rankUpdate(L21_T.transpose(), -1);
+    }
+
+    Eigen::LLT<Eigen::MatrixXd> llt(K22);
+    if (llt.info() != Eigen::Success)
+      throw std::runtime_error(
+          "The GP covariance matrix is not positive definite.");
 
-    // Compute self block.
-    Eigen::MatrixXd self_kernels = kernels[i]->struc_struc(
-        structure.descriptors[i], structure.descriptors[i],
-        kernels[i]->kernel_hyperparameters);
-
-    assign_kernels(self_kernels, Kff_kernels[i], n_energy, n_force, n_stress,
-                   n_atoms, n_energy, n_force, n_stress, n_atoms, n_labels,
-                   n_labels);
-
-    // // Compute kernels between new structure and previous structures.
-    // TODO: Store cumulative label counts to parallelize this loop.
-    // for (int j = 0; j < n_strucs; j++){
-    //   Eigen::MatrixXd struc_kernels =
-    //     kernels[i]->struc_struc(
-    //       structure.descriptors[i], training_structures[j].descriptors[i],
-    //       kernels[i]->kernel_hyperparameters);
-    // }
-
-    // struc_struc_kernels =
-    //     kernels[i]->envs_struc(sparse_descriptors[i],
-    //     structure.descriptors[i],
-    //                            kernels[i]->kernel_hyperparameters);
-
-    // Kff_kernels[i].block(0, n_labels, n_sparse, n_energy) =
-    //     envs_struc_kernels.block(0, 0, n_sparse, n_energy);
-    // Kff_kernels[i].block(0, n_labels + n_energy, n_sparse, n_force) =
-    //     envs_struc_kernels.block(0, 1, n_sparse, n_force);
-    // Kff_kernels[i].block(0, n_labels + n_energy + n_force, n_sparse,
-    // n_stress) =
-    //     envs_struc_kernels.block(0, 1 + n_atoms * 3, n_sparse, n_sparse);
+    L.conservativeResize(n_labels, n_labels);
+    L.block(0, n_factored, n_factored, n_new).setZero();
+    L.block(n_factored, 0, n_new, n_factored) = L21_T.transpose();
+    L.block(n_factored, n_factored, n_new, n_new) = llt.matrixL();
+    n_factored = n_labels;
   }
 
-  //   // Update labels.
-  //   label_count.conservativeResize(training_structures.size() + 2);
-  //   label_count(training_structures.size() + 1) = n_labels + n_struc_labels;
-  //   y.conservativeResize(n_labels + n_struc_labels);
-  //   y.segment(n_labels, n_energy) = structure.energy;
-  //   y.segment(n_labels + n_energy, n_force) = structure.forces;
-  //   y.segment(n_labels + n_energy + n_force, n_stress) = structure.stresses;
-
-  //   // Update noise.
-  //   noise_vector.conservativeResize(n_labels + n_struc_labels);
-  //   noise_vector.segment(n_labels, n_energy) =
-  //       Eigen::VectorXd::Constant(n_energy, 1 / (energy_noise *
-  //       energy_noise));
-  //   noise_vector.segment(n_labels + n_energy, n_force) =
-  //       Eigen::VectorXd::Constant(n_force, 1 / (force_noise * force_noise));
-  //   noise_vector.segment(n_labels + n_energy + n_force, n_stress) =
-  //       Eigen::VectorXd::Constant(n_stress, 1 / (stress_noise *
-  //       stress_noise));
-
-  //   // Update label count.
-  //   n_energy_labels += n_energy;
-  //   n_force_labels += n_force;
-  //   n_stress_labels += n_stress;
-  //   n_labels += n_struc_labels;
-
-  //   // Store training structure.
-  //   training_structures.push_back(structure);
-  //   n_strucs += 1;
-
-  //   // Update Kuf.
-  //   stack_Kuf();
+  // alpha = (Kff + noise)^-1 y
+  alpha = L.triangularView<Eigen::Lower>().solve(y);
+  L.transpose().triangularView<Eigen::Upper>().solveInPlace(alpha);
+}
+
+Eigen::MatrixXd GP ::struc_kernel_matrix(const Structure &structure) {
+  int n_atoms = structure.noa;
+  int n_out = 1 + 3 * n_atoms + 6;
+  Eigen::MatrixXd kernel_mat = Eigen::MatrixXd::Zero(n_labels, n_out);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int j = 0; j < n_strucs; j++) {
+    const Structure &struc_j = training_structures[j];
+    int ne_j = struc_j.energy.size();
+    int nf_j = struc_j.forces.size();
+    int ns_j = struc_j.stresses.size();
+    int n_struc_labels = ne_j + nf_j + ns_j;
+
+    Eigen::MatrixXd struc_kernels = Eigen::MatrixXd::Zero(n_struc_labels, n_out);
+    Eigen::MatrixXd kernel_block(n_struc_labels, n_out);
+    for (int i = 0; i < n_kernels; i++) {
+      assign_kernels(kernels[i]->struc_struc(
+                         struc_j.descriptors[i], structure.descriptors[i],
+                         kernels[i]->kernel_hyperparameters),
+                     kernel_block, ne_j, nf_j, ns_j, struc_j.noa, 1,
+                     3 * n_atoms, 6, n_atoms, 0, 0);
+      struc_kernels += kernel_block;
+    }
+    int row = label_count(j);
+    kernel_mat.block(row, 0, n_struc_labels, n_out) = struc_kernels;
+  }
+
+  return kernel_mat;
+}
+
+void GP ::predict(Structure &structure) {
+  int n_out = 1 + 3 * structure.noa + 6;
+
+  Eigen::MatrixXd kernel_mat = struc_kernel_matrix(structure);
+  structure.mean_efs = kernel_mat.transpose() * alpha;
+
+  // Compute variances with a triangular solve against the Cholesky factor,
+  // var = K_self - diag(K^T (Kff + noise)^-1 K) = K_self - |L^-1 K|^2.
+  Eigen::VectorXd K_self = Eigen::VectorXd::Zero(n_out);
+  for (int i = 0; i < n_kernels; i++) {
+    K_self += kernels[i]->self_kernel_struc(structure.descriptors[i],
+                                            kernels[i]->kernel_hyperparameters);
+  }
+
+  L.triangularView<Eigen::Lower>().solveInPlace(kernel_mat);
+  structure.variance_efs =
+      K_self - kernel_mat.colwise().squaredNorm().transpose();
+}
+
+void GP ::compute_likelihood() {
+  if (n_labels == 0) {
+    std::cout << "Warning: The likelihood is being computed without any "
+                 "labels in the training set. The result won't be meaningful."
+              << std::endl;
+    return;
+  }
+
+  if (n_factored < n_labels)
+    update_matrices();
+
+  // The log determinant of Kff + noise is twice the sum of the log diagonal
+  // of its Cholesky factor.
+  double half = 1.0 / 2.0;
+  complexity_penalty = -L.diagonal().array().log().sum();
+  data_fit = -half * y.dot(alpha);
+  constant_term = -half * n_labels * log(2 * M_PI);
+  log_marginal_likelihood = complexity_penalty + data_fit + constant_term;
+}
+
+void GP ::set_hyperparameters(Eigen::VectorXd hyps) {
+  int n_hyps, hyp_index = 0;
+  for (int i = 0; i < n_kernels; i++) {
+    n_hyps = kernels[i]->kernel_hyperparameters.size();
+    kernels[i]->set_hyperparameters(hyps.segment(hyp_index, n_hyps));
+    hyp_index += n_hyps;
+  }
+
+  hyperparameters = hyps;
+  energy_noise = hyps(hyp_index);
+  force_noise = hyps(hyp_index + 1);
+  stress_noise = hyps(hyp_index + 2);
+
+  // Every kernel and the Cholesky factor depend on the hyperparameters, so
+  // the training set is rebuilt from scratch.
+  std::vector<Structure> structures;
+  std::swap(structures, training_structures);
+  for (int i = 0; i < n_kernels; i++) {
+    Kff_kernels[i].resize(0, 0);
+  }
+  label_count = Eigen::VectorXd::Zero(1);
+  y.resize(0);
+  noise_vector.resize(0);
+  n_energy_labels = n_force_labels = n_stress_labels = 0;
+  n_labels = n_strucs = 0;
+  L.resize(0, 0);
+  n_factored = 0;
+
+  for (int i = 0; i < structures.size(); i++) {
+    add_training_structure(structures[i]);
+  }
+  update_matrices();
 }
 
 void assign_kernels(const Eigen::MatrixXd &efs_kernels,
@@ -134,7 +268,7 @@ void assign_kernels(const Eigen::MatrixXd &efs_kernels,
                     int col) {
 
   // EE, FF, SS kernels.
-  Kff_kernels.block(row, col, ne1, ne2) = efs_kernels.block(0, 0, ne1, ne1);
+  Kff_kernels.block(row, col, ne1, ne2) = efs_kernels.block(0, 0, ne1, ne2);
   Kff_kernels.block(row + ne1, col + ne2, nf1, nf2) =
       efs_kernels.block(1, 1, nf1, nf2);
   Kff_kernels.block(row + ne1 + nf1, col + ne2 + nf2, ns1, ns2) =
@@ -17,9 +17,12 @@ public:
   Eigen::MatrixXd Kff;
   int n_kernels = 0;
 
-  // Solution attributes.
-  Eigen::MatrixXd Kff_inverse;
+  // Solution attributes. L is the lower Cholesky factor of Kff plus the
+  // label noise. It covers the first n_factored labels and is extended by a
+  // block update when new structures are added.
+  Eigen::MatrixXd L;
   Eigen::VectorXd alpha;
+  int n_factored = 0;
 
   // Training points.
   std::vector<Structure> training_structures;
@@ -33,19 +36,20 @@ public:
   // Likelihood attributes.
   double log_marginal_likelihood, data_fit, complexity_penalty, trace_term,
       constant_term;
-  Eigen::VectorXd likelihood_gradient;
 
   GP();
   GP(std::vector<Kernel *> kernels, double energy_noise, double force_noise,
      double stress_noise);
 
-  // TODO:
   void add_training_structure(const Structure &structure);
   void update_matrices();
   void predict(Structure &structure);
   void compute_likelihood();
-  double compute_likelihood_gradient(const Eigen::VectorXd &hyperparameters);
   void set_hyperparameters(Eigen::VectorXd hyps);
+
+  // Kernel matrix between the training labels and the energy, forces and
+  // stress of a test structure (n_labels x (1 + 3 * noa + 6)).
+  Eigen::MatrixXd struc_kernel_matrix(const Structure &structure);
 };
 
 void assign_kernels(const Eigen::MatrixXd &efs_kernels,
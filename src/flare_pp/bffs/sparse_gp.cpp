@@ -1,10 +1,13 @@
 #include "sparse_gp.h"
+#include "binary.h"
 #include <algorithm> // Random shuffle
 #include <chrono>
 #include <fstream> // File operations
 #include <iomanip> // setprecision
 #include <iostream>
+#include <limits>
 #include <numeric> // Iota
+#include <stdexcept>
 #include <assert.h> 
 
 #define MAXLINE 1024
@@ -51,11 +54,12 @@ SparseGP ::SparseGP(std::vector<Kernel *> kernels, double energy_noise,
   Eigen::MatrixXd empty_matrix;
   for (int i = 0; i < kernels.size(); i++) {
     Kuu_kernels.push_back(empty_matrix);
-    Kuf_kernels.push_back(empty_matrix);
   }
 }
 
 void SparseGP ::initialize_sparse_descriptors(const Structure &structure) {
+  if (descriptor_calculators.size() == 0)
+    descriptor_calculators = structure.descriptor_calculators;
   if (sparse_descriptors.size() != 0)
     return;
 
@@ -103,28 +107,14 @@ SparseGP ::compute_cluster_uncertainties(const Structure &structure) {
   }
 
   // Compute cluster uncertainties.
-  std::vector<Eigen::VectorXd> K_self, Q_self, variances;
-  std::vector<Eigen::MatrixXd> sparse_kernels;
-  int sparse_count = 0;
+  std::vector<Eigen::VectorXd> variances;
   for (int i = 0; i < n_kernels; i++) {
-    K_self.push_back(
-        (kernels[i]->envs_envs(cluster_descriptors[i], cluster_descriptors[i],
-                               kernels[i]->kernel_hyperparameters))
-            .diagonal());
-
-    sparse_kernels.push_back(
+    Eigen::MatrixXd sparse_kernels =
         kernels[i]->envs_envs(cluster_descriptors[i], sparse_descriptors[i],
-                              kernels[i]->kernel_hyperparameters));
-
-    int n_clusters = sparse_descriptors[i].n_clusters;
-    Eigen::MatrixXd L_inverse_block =
-        L_inv.block(sparse_count, sparse_count, n_clusters, n_clusters);
-    sparse_count += n_clusters;
-
-    Eigen::MatrixXd Q1 = L_inverse_block * sparse_kernels[i].transpose();
-    Q_self.push_back((Q1.transpose() * Q1).diagonal());
-
-    variances.push_back(K_self[i] - Q_self[i]); // it is sorted by clusters, not the original atomic order 
+                              kernels[i]->kernel_hyperparameters);
+    variances.push_back(compute_cluster_variances(i, cluster_descriptors[i],
+                                                  sparse_kernels));
+    // it is sorted by clusters, not the original atomic order
     // TODO: If the environment is empty, the assigned uncertainty should be
     // set to zero.
   }
@@ -132,6 +122,79 @@ SparseGP ::compute_cluster_uncertainties(const Structure &structure) {
   return variances;
 }
 
+Eigen::VectorXd
+SparseGP ::compute_cluster_variances(int i, const ClusterDescriptor &clusters,
+                                     const Eigen::MatrixXd &sparse_kernels,
+                                     Eigen::MatrixXd *projections) {
+  int sparse_count = 0;
+  for (int k = 0; k < i; k++) {
+    sparse_count += sparse_descriptors[k].n_clusters;
+  }
+  int n_clusters = sparse_descriptors[i].n_clusters;
+  Eigen::MatrixXd L_inverse_block = solution_matrix("L_inv").block(
+      sparse_count, sparse_count, n_clusters, n_clusters);
+
+  Eigen::VectorXd K_self = kernels[i]->self_kernel_envs(
+      clusters, kernels[i]->kernel_hyperparameters);
+
+  // Q_self is the squared norm of L_inv k for each cluster k. It is
+  // computed in blocks of clusters so that only the diagonal of the Q
+  // matrix is formed.
+  int n_envs = clusters.n_clusters;
+  int block_size = 256;
+  int n_blocks = (n_envs + block_size - 1) / block_size;
+  Eigen::VectorXd Q_self(n_envs);
+  if (projections != nullptr)
+    projections->resize(n_clusters, n_envs);
+#pragma omp parallel for schedule(dynamic)
+  for (int b = 0; b < n_blocks; b++) {
+    int start = b * block_size;
+    int size = std::min(block_size, n_envs - start);
+    Eigen::MatrixXd Q1 =
+        L_inverse_block * sparse_kernels.middleRows(start, size).transpose();
+    Q_self.segment(start, size) = Q1.colwise().squaredNorm().transpose();
+    if (projections != nullptr)
+      projections->middleCols(start, size) = Q1;
+  }
+
+  return K_self - Q_self;
+}
+
+std::vector<int> SparseGP ::select_diverse_clusters(
+    int i, const DescriptorValues &structure, const ClusterDescriptor &clusters,
+    Eigen::VectorXd variances, const Eigen::MatrixXd &projections,
+    int n_select) {
+
+  // Greedy pivoted Cholesky factorization of the covariance of the clusters
+  // conditioned on the sparse set. Each step selects the cluster with the
+  // largest variance conditioned on the sparse set and on the clusters
+  // selected so far, so near duplicates of a selected cluster drop out.
+  int n_envs = clusters.n_clusters;
+  Eigen::MatrixXd G = Eigen::MatrixXd::Zero(n_envs, n_select);
+  std::vector<int> selected;
+  for (int t = 0; t < n_select; t++) {
+    int p;
+    double max_variance = variances.maxCoeff(&p);
+    if (!(max_variance > Kuu_jitter))
+      break;
+    selected.push_back(p);
+
+    ClusterDescriptor pivot(structure, std::vector<int>{p});
+    Eigen::VectorXd column =
+        kernels[i]->envs_envs(clusters, pivot,
+                              kernels[i]->kernel_hyperparameters)
+            .col(0);
+    column -= projections.transpose() * projections.col(p);
+    column -= G.leftCols(t) * G.row(p).head(t).transpose();
+
+    G.col(t) = column / sqrt(max_variance);
+    variances -= G.col(t).cwiseAbs2();
+    variances(p) = -std::numeric_limits<double>::infinity();
+  }
+
+  return selected;
+}
+
 void SparseGP ::add_specific_environments(const Structure &structure,
                                           const std::vector<int> atoms) {
 
@@ -139,25 +202,24 @@ void SparseGP ::add_specific_environments(const Structure &structure,
 
   // Gather clusters with central atom in the given list.
   std::vector<std::vector<std::vector<int>>> indices_1;
+  std::vector<std::vector<int>> added_clusters;
   for (int i = 0; i < n_kernels; i++){
-    sparse_indices[i].push_back(atoms); // for each kernel the added atoms are the same
-
-    int n_types = structure.descriptors[i].n_types;
-    std::vector<std::vector<int>> indices_2;
-    for (int j = 0; j < n_types; j++){
-      int n_clusters = structure.descriptors[i].n_clusters_by_type[j];
-      std::vector<int> indices_3;
-      for (int k = 0; k < n_clusters; k++){
-        int atom_index_1 = structure.descriptors[i].atom_indices[j](k);
-        for (int l = 0; l < atoms.size(); l++){
-          int atom_index_2 = atoms[l];
-          if (atom_index_1 == atom_index_2){
-            indices_3.push_back(k);
-          }
-        }
-      }
-      indices_2.push_back(indices_3);
+    const DescriptorValues &struc_desc = structure.descriptors[i];
+    std::vector<std::vector<int>> indices_2(struc_desc.n_types);
+    std::vector<int> clusters = struc_desc.clusters_of_atoms(atoms);
+    for (int k = 0; k < clusters.size(); k++) {
+      int type = struc_desc.cluster_type(clusters[k]);
+      indices_2[type].push_back(clusters[k] -
+                                struc_desc.cumulative_type_count[type]);
     }
+    clusters.clear();
+    for (int j = 0; j < struc_desc.n_types; j++) {
+      std::sort(indices_2[j].begin(), indices_2[j].end());
+      for (int k = 0; k < indices_2[j].size(); k++)
+        clusters.push_back(struc_desc.cumulative_type_count[j] +
+                           indices_2[j][k]);
+    }
+    added_clusters.push_back(clusters);
     indices_1.push_back(indices_2);
   }
 
@@ -173,34 +235,73 @@ void SparseGP ::add_specific_environments(const Structure &structure,
   update_Kuu(cluster_descriptors);
   update_Kuf(cluster_descriptors);
   stack_Kuu();
-  stack_Kuf();
 
   // Store sparse environments.
   for (int i = 0; i < n_kernels; i++) {
+    record_sparse_origins(i, structure.descriptors[i], added_clusters[i]);
     sparse_descriptors[i].add_clusters_by_type(structure.descriptors[i],
                                                indices_1[i]);
+    sparse_indices[i].push_back(atoms); // for each kernel the added atoms are the same
   }
 }
 
 void SparseGP ::add_uncertain_environments(const Structure &structure,
-                                           const std::vector<int> &n_added) {
+                                           const std::vector<int> &n_added,
+                                           bool diverse) {
 
   initialize_sparse_descriptors(structure);
-  // Compute cluster uncertainties.
-  std::vector<std::vector<int>> sorted_indices =
-      sort_clusters_by_uncertainty(structure);
 
+  // Score all clusters of the structure. The kernels between the clusters
+  // and the sparse set are computed once, and the columns of the selected
+  // clusters are reused to update Kuu.
   std::vector<std::vector<int>> n_sorted_indices;
+  std::vector<Eigen::MatrixXd> sparse_blocks;
   for (int i = 0; i < n_kernels; i++) {
-    // Take the first N indices.
-    int n_curr = n_added[i];
-    if (n_curr > sorted_indices[i].size())
-      n_curr = sorted_indices[i].size();
-    std::vector<int> n_indices(n_curr);
-    for (int j = 0; j < n_curr; j++) {
-      n_indices[j] = sorted_indices[i][j];
+    const DescriptorValues &struc_desc = structure.descriptors[i];
+    ClusterDescriptor clusters(struc_desc);
+    Eigen::MatrixXd sparse_kernels =
+        kernels[i]->envs_envs(clusters, sparse_descriptors[i],
+                              kernels[i]->kernel_hyperparameters);
+
+    int n_curr = std::min(n_added[i], clusters.n_clusters);
+    std::vector<int> n_indices;
+    if (diverse) {
+      Eigen::MatrixXd projections;
+      Eigen::VectorXd variances =
+          compute_cluster_variances(i, clusters, sparse_kernels, &projections);
+      n_indices = select_diverse_clusters(i, struc_desc, clusters, variances,
+                                          projections, n_curr);
+    } else {
+      // Take the N most uncertain clusters, in order of decreasing variance.
+      Eigen::VectorXd v =
+          compute_cluster_variances(i, clusters, sparse_kernels);
+      n_indices.resize(clusters.n_clusters);
+      iota(n_indices.begin(), n_indices.end(), 0);
+      partial_sort(n_indices.begin(), n_indices.begin() + n_curr,
+                   n_indices.end(), [&v](int i1, int i2) {
+                     return v(i1) > v(i2) || (v(i1) == v(i2) && i1 < i2);
+                   });
+      n_indices.resize(n_curr);
     }
     n_sorted_indices.push_back(n_indices);
+
+    // Columns of the selected clusters, in the order in which they are
+    // stored in the cluster descriptor (by type, then in selection order).
+    Eigen::MatrixXd sparse_block(sparse_descriptors[i].n_clusters,
+                                 n_indices.size());
+    std::vector<std::vector<int>> selected_by_type(struc_desc.n_types);
+    for (int j = 0; j < n_indices.size(); j++)
+      selected_by_type[struc_desc.cluster_type(n_indices[j])].push_back(
+          n_indices[j]);
+    int count = 0;
+    for (int s = 0; s < struc_desc.n_types; s++) {
+      for (int j = 0; j < selected_by_type[s].size(); j++) {
+        sparse_block.col(count) =
+            sparse_kernels.row(selected_by_type[s][j]).transpose();
+        count++;
+      }
+    }
+    sparse_blocks.push_back(sparse_block);
   }
 
   // Create cluster descriptors.
@@ -212,31 +313,21 @@ void SparseGP ::add_uncertain_environments(const Structure &structure,
   }
 
   // Update Kuu and Kuf.
-  update_Kuu(cluster_descriptors);
+  update_Kuu(cluster_descriptors, sparse_blocks);
   update_Kuf(cluster_descriptors);
   stack_Kuu();
-  stack_Kuf();
 
   // Store sparse environments.
   for (int i = 0; i < n_kernels; i++) {
+    record_sparse_origins(i, structure.descriptors[i], n_sorted_indices[i]);
     sparse_descriptors[i].add_clusters(structure.descriptors[i],
                                        n_sorted_indices[i]);
 
     // find the atom index of added sparse env
     std::vector<int> added_indices;
     for (int k = 0; k < n_sorted_indices[i].size(); k++) {
-      int cluster_val = n_sorted_indices[i][k];
-      int atom_index, val;
-      for (int j = 0; j < structure.descriptors[i].n_types; j++) {
-        int ccount = structure.descriptors[i].cumulative_type_count[j];
-        int ccount_p1 = structure.descriptors[i].cumulative_type_count[j + 1];
-        if ((cluster_val >= ccount) && (cluster_val < ccount_p1)) {
-          val = cluster_val - ccount;
-          atom_index = structure.descriptors[i].atom_indices[j][val];
-          added_indices.push_back(atom_index);
-          break;
-        }
-      }
+      added_indices.push_back(
+          structure.descriptors[i].cluster_atom(n_sorted_indices[i][k]));
     }
 
     sparse_indices[i].push_back(added_indices);
@@ -276,27 +367,17 @@ void SparseGP ::add_random_environments(const Structure &structure,
   update_Kuu(cluster_descriptors);
   update_Kuf(cluster_descriptors);
   stack_Kuu();
-  stack_Kuf();
 
   // Store sparse environments.
   for (int i = 0; i < n_kernels; i++) {
+    record_sparse_origins(i, structure.descriptors[i], envs1[i]);
     sparse_descriptors[i].add_clusters(structure.descriptors[i], envs1[i]);
 
     // find the atom index of added sparse env
     std::vector<int> added_indices;
     for (int k = 0; k < envs1[i].size(); k++) {
-      int cluster_val = envs1[i][k];
-      int atom_index, val;
-      for (int j = 0; j < structure.descriptors[i].n_types; j++) {
-        int ccount = structure.descriptors[i].cumulative_type_count[j];
-        int ccount_p1 = structure.descriptors[i].cumulative_type_count[j + 1];
-        if ((cluster_val >= ccount) && (cluster_val < ccount_p1)) {
-          val = cluster_val - ccount;
-          atom_index = structure.descriptors[i].atom_indices[j][val];
-          added_indices.push_back(atom_index);
-          break;
-        }
-      }
+      added_indices.push_back(
+          structure.descriptors[i].cluster_atom(envs1[i][k]));
     }
     sparse_indices[i].push_back(added_indices);
   }
@@ -317,7 +398,6 @@ void SparseGP ::add_all_environments(const Structure &structure) {
   update_Kuu(cluster_descriptors);
   update_Kuf(cluster_descriptors);
   stack_Kuu();
-  stack_Kuf();
 
   // Store sparse environments.
   std::vector<int> added_indices;
@@ -325,19 +405,272 @@ void SparseGP ::add_all_environments(const Structure &structure) {
     added_indices.push_back(j);
   }
   for (int i = 0; i < n_kernels; i++) {
+    std::vector<int> clusters(structure.descriptors[i].n_clusters);
+    std::iota(clusters.begin(), clusters.end(), 0);
+    record_sparse_origins(i, structure.descriptors[i], clusters);
     sparse_descriptors[i].add_all_clusters(structure.descriptors[i]);
     sparse_indices[i].push_back(added_indices);
   }
 }
 
+void SparseGP ::record_sparse_origins(int i, const DescriptorValues &structure,
+                                      const std::vector<int> &clusters) {
+  sparse_origins.resize(n_kernels);
+  std::vector<std::pair<int, int>> &origins = sparse_origins[i];
+  const ClusterDescriptor &sparse = sparse_descriptors[i];
+  if (origins.size() != sparse.n_clusters)
+    origins.assign(sparse.n_clusters, std::make_pair(-1, -1));
+
+  // New clusters are stored after the sparse environments of their type.
+  int call = sparse_indices[i].size();
+  std::vector<std::vector<std::pair<int, int>>> added(sparse.n_types);
+  for (int k = 0; k < clusters.size(); k++) {
+    added[structure.cluster_type(clusters[k])].push_back(
+        std::make_pair(call, structure.cluster_atom(clusters[k])));
+  }
+
+  std::vector<std::pair<int, int>> updated;
+  for (int s = 0; s < sparse.n_types; s++) {
+    int start = sparse.cumulative_type_count[s];
+    updated.insert(updated.end(), origins.begin() + start,
+                   origins.begin() + start + sparse.n_clusters_by_type[s]);
+    updated.insert(updated.end(), added[s].begin(), added[s].end());
+  }
+  origins.swap(updated);
+}
+
+// Greedily select points of the kernel matrix K whose variance conditioned
+// on the other remaining points is at most min_relative_variance times their
+// prior variance, starting from the most redundant point. Removing a point
+// from the precision matrix P = (K + jitter I)^-1 is a rank one downdate.
+static std::vector<int> redundant_points(const Eigen::MatrixXd &K,
+                                         double jitter,
+                                         double min_relative_variance) {
+  int n = K.rows();
+  std::vector<int> removed;
+  if (n < 2)
+    return removed;
+
+  Eigen::MatrixXd eye = Eigen::MatrixXd::Identity(n, n);
+  Eigen::MatrixXd P = (K + jitter * eye).llt().solve(eye);
+  std::vector<bool> active(n, true);
+
+  // Keep at least one point.
+  while (removed.size() < n - 1) {
+    int p = -1;
+    double min_ratio = min_relative_variance;
+    for (int j = 0; j < n; j++) {
+      double ratio = 1 / (P(j, j) * K(j, j));
+      if (active[j] && ratio <= min_ratio) {
+        p = j;
+        min_ratio = ratio;
+      }
+    }
+    if (p == -1)
+      break;
+
+    // The row and column of p become zero.
+    Eigen::VectorXd col = P.col(p);
+    P.noalias() -= col * col.transpose() / col(p);
+    active[p] = false;
+    removed.push_back(p);
+  }
+
+  std::sort(removed.begin(), removed.end());
+  return removed;
+}
+
+// Restrict an upper triangular factor R with R^T R = M to the columns in
+// kept (in increasing order), so that the result is the factor of M
+// restricted to kept. Deleting columns leaves nonzeros below the diagonal,
+// which are removed with Givens rotations. The rotations are also applied to
+// b if it is not null.
+static void delete_factor_columns(Eigen::MatrixXd &R, Eigen::VectorXd *b,
+                                  const std::vector<int> &kept) {
+  int n = R.rows();
+  int m = kept.size();
+  int n_cols = (b == nullptr) ? m : m + 1;
+  Eigen::MatrixXd M(n, n_cols);
+  for (int j = 0; j < m; j++) {
+    M.col(j) = R.col(kept[j]);
+  }
+  if (b != nullptr)
+    M.col(m) = *b;
+
+  for (int j = 0; j < m; j++) {
+    // Rows below kept[j] are still zero in column j.
+    for (int r = j + 1; r <= kept[j]; r++) {
+      if (M(r, j) == 0)
+        continue;
+      Eigen::JacobiRotation<double> G;
+      G.makeGivens(M(j, j), M(r, j));
+      M.rightCols(n_cols - j).applyOnTheLeft(j, r, G.adjoint());
+      M(r, j) = 0;
+    }
+    if (M(j, j) < 0)
+      M.row(j) *= -1;
+  }
+
+  R = M.topLeftCorner(m, m).triangularView<Eigen::Upper>();
+  if (b != nullptr)
+    *b = M.col(m).head(m);
+}
+
+void SparseGP ::remove_sparse_environments(
+    const std::vector<std::vector<int>> &removed) {
+  if (removed.size() != n_kernels)
+    throw std::invalid_argument(
+        "Removed environments must be given for each kernel.");
+  for (int i = 0; i < n_kernels; i++) {
+    for (int k = 0; k < removed[i].size(); k++) {
+      if (removed[i][k] < 0 ||
+          removed[i][k] >= sparse_descriptors[i].n_clusters)
+        throw std::invalid_argument(
+            "Removed environment " + std::to_string(removed[i][k]) +
+            " of kernel " + std::to_string(i) + " is out of range.");
+    }
+  }
+
+  // Rows of Kuu that are kept, and the new row of each kept row.
+  std::vector<int> kept_rows, new_rows(n_sparse, -1);
+  int offset = 0;
+  for (int i = 0; i < n_kernels; i++) {
+    int n_sparse_i = sparse_descriptors[i].n_clusters;
+    std::vector<bool> is_removed(n_sparse_i, false);
+    for (int k = 0; k < removed[i].size(); k++) {
+      is_removed[removed[i][k]] = true;
+    }
+
+    std::vector<int> kept;
+    for (int k = 0; k < n_sparse_i; k++) {
+      if (!is_removed[k]) {
+        new_rows[offset + k] = kept_rows.size();
+        kept_rows.push_back(offset + k);
+        kept.push_back(k);
+      }
+    }
+    Eigen::MatrixXd Kuu_kept(kept.size(), kept.size());
+    for (int k = 0; k < kept.size(); k++) {
+      for (int l = 0; l < kept.size(); l++) {
+        Kuu_kept(l, k) = Kuu_kernels[i](kept[l], kept[k]);
+      }
+    }
+    Kuu_kernels[i].swap(Kuu_kept);
+
+    // Remove the atoms of the removed environments from sparse_indices.
+    std::vector<std::pair<int, int>> kept_origins;
+    bool origins_known = (sparse_origins.size() == n_kernels) &&
+                         (sparse_origins[i].size() == n_sparse_i);
+    for (int k = 0; k < n_sparse_i && origins_known; k++) {
+      std::pair<int, int> origin = sparse_origins[i][k];
+      if (!is_removed[k]) {
+        kept_origins.push_back(origin);
+      } else if (origin.first != -1) {
+        std::vector<int> &atoms = sparse_indices[i][origin.first];
+        std::vector<int>::iterator it =
+            std::find(atoms.begin(), atoms.end(), origin.second);
+        if (it != atoms.end())
+          atoms.erase(it);
+      }
+    }
+    if (origins_known)
+      sparse_origins[i].swap(kept_origins);
+
+    std::vector<int> removed_i;
+    for (int k = 0; k < n_sparse_i; k++) {
+      if (is_removed[k])
+        removed_i.push_back(k);
+    }
+    sparse_descriptors[i].remove_clusters(removed_i);
+    offset += n_sparse_i;
+  }
+
+  // Kuf is empty in models loaded for prediction only.
+  if (Kuf.rows() == n_sparse) {
+    Eigen::MatrixXd Kuf_kept(kept_rows.size(), Kuf.cols());
+    for (int k = 0; k < kept_rows.size(); k++) {
+      Kuf_kept.row(k) = Kuf.row(kept_rows[k]);
+    }
+    Kuf.swap(Kuf_kept);
+  }
+  n_sparse = kept_rows.size();
+  stack_Kuu();
+
+  // Cached contractions of the previous sparse set.
+  clear_Kuf_contractions();
+
+  // Downdate the factors. Factor columns of removed environments are
+  // deleted; the others keep their order.
+  std::vector<int> kept_factors, kept_indices;
+  for (int i = 0; i < factor_indices.size(); i++) {
+    int row = new_rows[factor_indices[i]];
+    if (row != -1) {
+      kept_factors.push_back(i);
+      kept_indices.push_back(row);
+    }
+  }
+  factor_indices = kept_indices;
+  if (!factors_current || kept_factors.size() == 0) {
+    factor_indices.clear();
+    factors_current = false;
+    return;
+  }
+  if (kept_factors.size() == L_factor.rows())
+    return;
+
+  Eigen::MatrixXd L_transpose = L_factor.transpose();
+  delete_factor_columns(L_transpose, nullptr, kept_factors);
+  L_factor = L_transpose.transpose();
+  delete_factor_columns(R_factor, &Q_b, kept_factors);
+}
+
+std::vector<std::vector<int>>
+SparseGP ::prune_sparse_environments(double min_relative_variance) {
+  std::vector<std::vector<int>> removed;
+  for (int i = 0; i < n_kernels; i++) {
+    const ClusterDescriptor &sparse = sparse_descriptors[i];
+    std::vector<int> removed_i;
+    if (kernels[i]->type_diagonal()) {
+      // Environments of different types are uncorrelated.
+      for (int s = 0; s < sparse.n_types; s++) {
+        int start = sparse.cumulative_type_count[s];
+        int size = sparse.n_clusters_by_type[s];
+        std::vector<int> points =
+            redundant_points(Kuu_kernels[i].block(start, start, size, size),
+                             Kuu_jitter, min_relative_variance);
+        for (int k = 0; k < points.size(); k++) {
+          removed_i.push_back(start + points[k]);
+        }
+      }
+    } else {
+      removed_i =
+          redundant_points(Kuu_kernels[i], Kuu_jitter, min_relative_variance);
+    }
+    removed.push_back(removed_i);
+  }
+
+  remove_sparse_environments(removed);
+  return removed;
+}
+
 void SparseGP ::update_Kuu(
-    const std::vector<ClusterDescriptor> &cluster_descriptors) {
+    const std::vector<ClusterDescriptor> &cluster_descriptors,
+    const std::vector<Eigen::MatrixXd> &sparse_blocks) {
+
+  // Map from old to new rows of the stacked Kuu matrix, used to keep track
+  // of the factored sparse environments.
+  std::vector<int> index_map;
+  int new_offset = 0;
 
   // Update Kuu matrices.
   for (int i = 0; i < n_kernels; i++) {
-    Eigen::MatrixXd prev_block =
-        kernels[i]->envs_envs(sparse_descriptors[i], cluster_descriptors[i],
-                              kernels[i]->kernel_hyperparameters);
+    Eigen::MatrixXd prev_block;
+    if (sparse_blocks.size() == n_kernels)
+      prev_block = sparse_blocks[i];
+    else
+      prev_block =
+          kernels[i]->envs_envs(sparse_descriptors[i], cluster_descriptors[i],
+                                kernels[i]->kernel_hyperparameters);
     Eigen::MatrixXd self_block =
         kernels[i]->envs_envs(cluster_descriptors[i], cluster_descriptors[i],
                               kernels[i]->kernel_hyperparameters);
@@ -349,116 +682,335 @@ void SparseGP ::update_Kuu(
     Eigen::MatrixXd kern_mat =
         Eigen::MatrixXd::Zero(n_sparse + n_envs, n_sparse + n_envs);
 
-    int n1 = 0; // Sparse descriptor counter 1
-    int n2 = 0; // Cluster descriptor counter 1
+    if (kernels[i]->type_diagonal()) {
+      // Cross-type blocks vanish, so only the diagonal block of each type is
+      // copied and extended.
+      int n1 = 0; // Sparse descriptor count
+      int n2 = 0; // Cluster descriptor count
+      for (int j = 0; j < n_types; j++) {
+        int n3 = sparse_descriptors[i].n_clusters_by_type[j];
+        int n4 = cluster_descriptors[i].n_clusters_by_type[j];
+        int start = n1 + n2;
+
+        kern_mat.block(start, start, n3, n3) =
+            Kuu_kernels[i].block(n1, n1, n3, n3);
+        kern_mat.block(start, start + n3, n3, n4) =
+            prev_block.block(n1, n2, n3, n4);
+        kern_mat.block(start + n3, start, n4, n3) =
+            prev_block.block(n1, n2, n3, n4).transpose();
+        kern_mat.block(start + n3, start + n3, n4, n4) =
+            self_block.block(n2, n2, n4, n4);
+
+        n1 += n3;
+        n2 += n4;
+      }
+    } else {
+      int n1 = 0; // Sparse descriptor counter 1
+      int n2 = 0; // Cluster descriptor counter 1
+
+      for (int j = 0; j < n_types; j++) {
+        int n3 = 0; // Sparse descriptor counter 2
+        int n4 = 0; // Cluster descriptor counter 2
+        int n5 = sparse_descriptors[i].n_clusters_by_type[j];
+        int n6 = cluster_descriptors[i].n_clusters_by_type[j];
+
+        for (int k = 0; k < n_types; k++){
+          int n7 = sparse_descriptors[i].n_clusters_by_type[k];
+          int n8 = cluster_descriptors[i].n_clusters_by_type[k];
+
+          Eigen::MatrixXd prev_vals_1 = prev_block.block(n1, n4, n5, n8);
+          Eigen::MatrixXd prev_vals_2 = prev_block.block(n3, n2, n7, n6);
+          Eigen::MatrixXd self_vals = self_block.block(n2, n4, n6, n8);
+
+          kern_mat.block(n1 + n2, n3 + n4, n5, n7) =
+            Kuu_kernels[i].block(n1, n3, n5, n7);
+          kern_mat.block(n1 + n2, n3 + n4 + n7, n5, n8) =
+            prev_vals_1;
+          kern_mat.block(n1 + n2 + n5, n3 + n4, n6, n7) =
+            prev_vals_2.transpose();
+          kern_mat.block(n1 + n2 + n5, n3 + n4 + n7, n6, n8) =
+            self_vals;
+
+          n3 += n7;
+          n4 += n8;
+        }
 
-    // TODO: Generalize to allow comparisons across types.
+        n1 += n5;
+        n2 += n6;
+      }
+    }
+
+    // Previous environments of type j are shifted by the new environments
+    // of the preceding types.
+    int n1 = 0;
+    int n2 = 0;
     for (int j = 0; j < n_types; j++) {
-      int n3 = 0; // Sparse descriptor counter 2
-      int n4 = 0; // Cluster descriptor counter 2
-      int n5 = sparse_descriptors[i].n_clusters_by_type[j];
-      int n6 = cluster_descriptors[i].n_clusters_by_type[j];
-
-      for (int k = 0; k < n_types; k++){
-        int n7 = sparse_descriptors[i].n_clusters_by_type[k];
-        int n8 = cluster_descriptors[i].n_clusters_by_type[k];
-
-        Eigen::MatrixXd prev_vals_1 = prev_block.block(n1, n4, n5, n8);
-        Eigen::MatrixXd prev_vals_2 = prev_block.block(n3, n2, n7, n6);
-        Eigen::MatrixXd self_vals = self_block.block(n2, n4, n6, n8);
-
-        kern_mat.block(n1 + n2, n3 + n4, n5, n7) =
-          Kuu_kernels[i].block(n1, n3, n5, n7);
-        kern_mat.block(n1 + n2, n3 + n4 + n7, n5, n8) =
-          prev_vals_1;
-        kern_mat.block(n1 + n2 + n5, n3 + n4, n6, n7) =
-          prev_vals_2.transpose();
-        kern_mat.block(n1 + n2 + n5, n3 + n4 + n7, n6, n8) =
-          self_vals;
-
-        n3 += n7;
-        n4 += n8;
+      int n3 = sparse_descriptors[i].n_clusters_by_type[j];
+      for (int k = 0; k < n3; k++) {
+        index_map.push_back(new_offset + n1 + n2 + k);
       }
-      n1 += n5;
-      n2 += n6;
+      n1 += n3;
+      n2 += cluster_descriptors[i].n_clusters_by_type[j];
     }
-    Kuu_kernels[i] = kern_mat;
+
+    Kuu_kernels[i].swap(kern_mat);
+    new_offset += n_sparse + n_envs;
 
     // Update sparse count.
     this->n_sparse += n_envs;
-    }
   }
 
+  for (int i = 0; i < factor_indices.size(); i++) {
+    factor_indices[i] = index_map[factor_indices[i]];
+  }
+}
+
 void SparseGP ::update_Kuf(
     const std::vector<ClusterDescriptor> &cluster_descriptors) {
 
-  // Compute kernels between new sparse environments and training structures.
+  // The cached contractions only cover the previous sparse set.
+  clear_Kuf_contractions();
+
+  // Compute kernels between new sparse environments and training labels.
+  std::vector<Eigen::MatrixXd> env_rows(n_kernels);
   for (int i = 0; i < n_kernels; i++) {
-    int n_sparse = sparse_descriptors[i].n_clusters;
+    env_rows[i].resize(cluster_descriptors[i].n_clusters, n_labels);
+  }
+
+  // Compressed structures only give exact kernels for environments in the
+  // span they were compressed against. Otherwise their descriptors are
+  // recomputed from the stored positions and kept in full, or compressed
+  // again against the enlarged sparse set if recompress_training is set
+  // (see compact_training).
+  std::vector<char> recompute(n_strucs, 0);
+  for (int j = 0; j < n_strucs; j++) {
+    const Structure &struc = training_structures[j];
+    for (int i = 0; i < n_kernels; i++) {
+      if (!struc.descriptors[i].force_dervs_span_contains(
+              cluster_descriptors[i]))
+        recompute[j] = 1;
+    }
+    for (int i = 0; i < struc.descriptor_calculators.size() && recompute[j];
+         i++) {
+      if (struc.descriptor_calculators[i] == nullptr)
+        throw std::runtime_error(
+            "The descriptors of a compressed training structure cannot be "
+            "recomputed without its descriptor calculators.");
+    }
+  }
+
+#pragma omp parallel for schedule(dynamic)
+  for (int j = 0; j < n_strucs; j++) {
+    Structure &struc = training_structures[j];
+    int n_atoms = struc.noa;
+
+    Structure full;
+    if (recompute[j]) {
+      full = struc;
+      full.compute_neighbors();
+      full.compute_descriptors();
+    }
+
+    for (int i = 0; i < n_kernels; i++) {
+      const DescriptorValues &struc_desc =
+          recompute[j] ? full.descriptors[i] : struc.descriptors[i];
+      Eigen::MatrixXd envs_struc_kernels;
+      if (struc_desc.compressed())
+        envs_struc_kernels = kernels[i]->envs_struc(
+            cluster_descriptors[i], struc_desc.expand_force_dervs(),
+            kernels[i]->kernel_hyperparameters);
+      else
+        envs_struc_kernels = kernels[i]->envs_struc(
+            cluster_descriptors[i], struc_desc,
+            kernels[i]->kernel_hyperparameters);
+
+      int col = label_count(j);
+      if (struc.energy.size() != 0) {
+        env_rows[i].col(col) = envs_struc_kernels.col(0);
+        col += 1;
+      }
+
+      if (struc.forces.size() != 0) {
+        // Allow adding a subset of force labels
+        const std::vector<int> &atom_indices = training_atom_indices[j];
+        for (int a = 0; a < atom_indices.size(); a++) {
+          env_rows[i].middleCols(col, 3) =
+              envs_struc_kernels.middleCols(1 + atom_indices[a] * 3, 3);
+          col += 3;
+        }
+      }
+
+      if (struc.stresses.size() != 0) {
+        env_rows[i].middleCols(col, 6) =
+            envs_struc_kernels.middleCols(1 + n_atoms * 3, 6);
+      }
+    }
+
+    if (recompute[j]) {
+      if (recompress_training)
+        full.compress(sparse_descriptors, cluster_descriptors);
+      else
+        full.clear_neighbor_lists();
+      struc = full;
+    }
+  }
+
+  // New sparse environments are inserted after the previous environments of
+  // the same type. Only their rows are computed; the previous rows are moved
+  // into the enlarged matrix one type block at a time, which briefly holds
+  // two copies of Kuf. The move is O(n_sparse * n_labels), below the
+  // O(n_sparse * n_labels * n_new) of the incremental QR update that
+  // follows (see append_sparse_QR). n_sparse already includes the new
+  // environments (see update_Kuu).
+  Eigen::MatrixXd Kuf_new(n_sparse, n_labels);
+  int old_offset = 0, new_offset = 0;
+  for (int i = 0; i < n_kernels; i++) {
+    int n_sparse_i = sparse_descriptors[i].n_clusters;
     int n_envs = cluster_descriptors[i].n_clusters;
     int n_types = cluster_descriptors[i].n_types;
 
-    // Precompute indices.
-    Eigen::ArrayXi inds = Eigen::ArrayXi::Zero(n_types + 1);
-    int counter = 0;
-    for (int j = 0; j < n_types; j++) {
-      int t1 = sparse_descriptors[i].n_clusters_by_type[j];
-      int t2 = cluster_descriptors[i].n_clusters_by_type[j];
-      counter += t1 + t2;
-      inds(j + 1) = counter;
+    int n1 = 0; // Sparse descriptor count
+    int n2 = 0; // Cluster descriptor count
+    for (int k = 0; k < n_types; k++) {
+      int n3 = sparse_descriptors[i].n_clusters_by_type[k];
+      int n4 = cluster_descriptors[i].n_clusters_by_type[k];
+
+      Kuf_new.middleRows(new_offset + n1 + n2, n3) =
+          Kuf.middleRows(old_offset + n1, n3);
+      Kuf_new.middleRows(new_offset + n1 + n2 + n3, n4) =
+          env_rows[i].middleRows(n2, n4);
+
+      n1 += n3;
+      n2 += n4;
     }
 
-    Eigen::MatrixXd kern_mat =
-        Eigen::MatrixXd::Zero(n_sparse + n_envs, n_labels);
+    old_offset += n_sparse_i;
+    new_offset += n_sparse_i + n_envs;
+  }
+
+  Kuf.swap(Kuf_new);
+}
+
+void SparseGP ::clear_Kuf_contractions() {
+  Kuf_contractions.clear();
+  Kuf_contractions_bytes = 0;
+}
+
+std::vector<std::vector<Eigen::MatrixXd>>
+SparseGP ::compute_Kuf_grads(const Eigen::VectorXd &hyperparameters) {
 
-#pragma omp parallel for
+  std::vector<std::vector<Eigen::MatrixXd>> Kuf_grads(n_kernels);
+  std::vector<Eigen::VectorXd> kernel_hyps(n_kernels);
+  std::vector<std::pair<int, int>> tasks;
+  Kuf_contractions.resize(n_kernels);
+
+  // Contractions of the first structure, computed to check whether each
+  // kernel supports them when they are not cached.
+  std::vector<std::vector<Eigen::MatrixXd>> first_contractions(n_kernels);
+
+  int hyp_index = 0;
+  for (int i = 0; i < n_kernels; i++) {
+    int n_hyps = kernels[i]->kernel_hyperparameters.size();
+    kernel_hyps[i] = hyperparameters.segment(hyp_index, n_hyps);
+    hyp_index += n_hyps;
+    Kuf_contractions[i].resize(n_strucs);
+
+    // Kernels without contractions fall back on their own Kuf_grad.
+    bool supported = n_strucs > 0 && Kuf_contractions[i][0].size() != 0;
+    if (n_strucs > 0 && !supported) {
+      const DescriptorValues &struc_desc = training_structures[0].descriptors[i];
+      if (struc_desc.compressed())
+        first_contractions[i] = kernels[i]->envs_struc_contractions(
+            sparse_descriptors[i], struc_desc.expand_force_dervs());
+      else
+        first_contractions[i] = kernels[i]->envs_struc_contractions(
+            sparse_descriptors[i], struc_desc);
+      supported = first_contractions[i].size() != 0;
+    }
+    if (!supported) {
+      Kuf_grads[i] = kernels[i]->Kuf_grad(sparse_descriptors[i],
+                                          training_structures, i,
+                                          Kuf_kernel(i), kernel_hyps[i]);
+      continue;
+    }
+
+    for (int j = 0; j < n_hyps + 1; j++) {
+      Kuf_grads[i].push_back(
+          Eigen::MatrixXd::Zero(sparse_descriptors[i].n_clusters, n_labels));
+    }
     for (int j = 0; j < n_strucs; j++) {
-      int n_atoms = training_structures[j].noa;
-      Eigen::MatrixXd envs_struc_kernels = kernels[i]->envs_struc(
-          cluster_descriptors[i], training_structures[j].descriptors[i],
-          kernels[i]->kernel_hyperparameters);
+      tasks.push_back(std::make_pair(i, j));
+    }
+  }
 
-      int n1 = 0; // Sparse descriptor count
-      int n2 = 0; // Cluster descriptor count
-      for (int k = 0; k < n_types; k++) {
-        int current_count = 0;
-        int u_ind = inds(k);
-        int n3 = sparse_descriptors[i].n_clusters_by_type[k];
-        int n4 = cluster_descriptors[i].n_clusters_by_type[k];
-
-        if (training_structures[j].energy.size() != 0) {
-          kern_mat.block(u_ind, label_count(j), n3, 1) =
-              Kuf_kernels[i].block(n1, label_count(j), n3, 1);
-          kern_mat.block(u_ind + n3, label_count(j), n4, 1) =
-              envs_struc_kernels.block(n2, 0, n4, 1);
-
-          current_count += 1;
+#pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < tasks.size(); t++) {
+    int i = tasks[t].first;
+    int j = tasks[t].second;
+    const Structure &struc = training_structures[j];
+    DescriptorValues expanded;
+    if (struc.descriptors[i].compressed())
+      expanded = struc.descriptors[i].expand_force_dervs();
+    const DescriptorValues &struc_desc =
+        struc.descriptors[i].compressed() ? expanded : struc.descriptors[i];
+
+    std::vector<Eigen::MatrixXd> computed;
+    const std::vector<Eigen::MatrixXd> *contractions = &Kuf_contractions[i][j];
+    if (contractions->size() == 0) {
+      if (j == 0 && first_contractions[i].size() != 0)
+        computed.swap(first_contractions[i]);
+      else
+        computed =
+            kernels[i]->envs_struc_contractions(sparse_descriptors[i], struc_desc);
+      contractions = &computed;
+
+      // Cache the contractions if they fit in the limit.
+      size_t bytes = 0;
+      for (int k = 0; k < computed.size(); k++)
+        bytes += computed[k].size() * sizeof(double);
+      bool cached = false;
+#pragma omp critical(Kuf_contractions_cache)
+      {
+        if (Kuf_contractions_bytes + bytes <= Kuf_contractions_limit) {
+          Kuf_contractions_bytes += bytes;
+          cached = true;
         }
+      }
+      if (cached) {
+        Kuf_contractions[i][j].swap(computed);
+        contractions = &Kuf_contractions[i][j];
+      }
+    }
+    std::vector<Eigen::MatrixXd> envs_struc = kernels[i]->envs_struc_grad_cached(
+        sparse_descriptors[i], struc_desc, *contractions, kernel_hyps[i]);
 
-        if (training_structures[j].forces.size() != 0) {
-          std::vector<int> atom_indices = training_atom_indices[j];
-          for (int a = 0; a < atom_indices.size(); a++) {  // Allow adding a subset of force labels
-            kern_mat.block(u_ind, label_count(j) + current_count, n3, 3) =
-                Kuf_kernels[i].block(n1, label_count(j) + current_count, n3, 3);
-            kern_mat.block(u_ind + n3, label_count(j) + current_count, n4, 3) =
-                envs_struc_kernels.block(n2, 1 + atom_indices[a] * 3, n4, 3);
-            current_count += 3;
-          }
-        }
+    // Copy the columns of the stored labels.
+    int n_sparse = sparse_descriptors[i].n_clusters;
+    for (int k = 0; k < envs_struc.size(); k++) {
+      int current_count = 0;
+      if (struc.energy.size() != 0) {
+        Kuf_grads[i][k].block(0, label_count(j), n_sparse, 1) =
+            envs_struc[k].block(0, 0, n_sparse, 1);
+        current_count += 1;
+      }
 
-        if (training_structures[j].stresses.size() != 0) {
-          kern_mat.block(u_ind, label_count(j) + current_count, n3, 6) =
-              Kuf_kernels[i].block(n1, label_count(j) + current_count, n3, 6);
-          kern_mat.block(u_ind + n3, label_count(j) + current_count, n4, 6) =
-              envs_struc_kernels.block(n2, 1 + n_atoms * 3, n4, 6);
+      if (struc.forces.size() != 0) {
+        const std::vector<int> &atom_indices = training_atom_indices[j];
+        for (int a = 0; a < atom_indices.size(); a++) {
+          Kuf_grads[i][k].block(0, label_count(j) + current_count, n_sparse, 3) =
+              envs_struc[k].block(0, 1 + atom_indices[a] * 3, n_sparse, 3);
+          current_count += 3;
         }
+      }
 
-        n1 += n3;
-        n2 += n4;
+      if (struc.stresses.size() != 0) {
+        Kuf_grads[i][k].block(0, label_count(j) + current_count, n_sparse, 6) =
+            envs_struc[k].block(0, 1 + struc.noa * 3, n_sparse, 6);
       }
     }
-    Kuf_kernels[i] = kern_mat;
   }
+
+  return Kuf_grads;
 }
 
 void SparseGP ::add_training_structure(const Structure &structure,
@@ -536,25 +1088,26 @@ void SparseGP ::add_training_structure(const Structure &structure,
   inv_s_noise_one.segment(n_labels + n_energy + n_force, n_stress) =
       Eigen::VectorXd::Constant(n_stress, rel_s_noise * rel_s_noise);
 
-  // Update Kuf kernels.
+  // Append the columns of the new labels to Kuf.
+  Kuf.conservativeResize(n_sparse, n_labels + n_struc_labels);
   Eigen::MatrixXd envs_struc_kernels;
   for (int i = 0; i < n_kernels; i++) {
-    int n_sparse = sparse_descriptors[i].n_clusters;
+    Eigen::MatrixXd::RowsBlockXpr Kuf_i = Kuf_kernel(i);
+    int n_sparse_i = Kuf_i.rows();
 
     envs_struc_kernels = // contain all atoms
         kernels[i]->envs_struc(sparse_descriptors[i], structure.descriptors[i],
                                kernels[i]->kernel_hyperparameters);
 
-    Kuf_kernels[i].conservativeResize(n_sparse, n_labels + n_struc_labels);
-    Kuf_kernels[i].block(0, n_labels, n_sparse, n_energy) =
-        envs_struc_kernels.block(0, 0, n_sparse, n_energy);
-    Kuf_kernels[i].block(0, n_labels + n_energy + n_force, n_sparse, n_stress) =
-        envs_struc_kernels.block(0, 1 + n_atoms * 3, n_sparse, n_stress);
+    Kuf_i.block(0, n_labels, n_sparse_i, n_energy) =
+        envs_struc_kernels.block(0, 0, n_sparse_i, n_energy);
+    Kuf_i.block(0, n_labels + n_energy + n_force, n_sparse_i, n_stress) =
+        envs_struc_kernels.block(0, 1 + n_atoms * 3, n_sparse_i, n_stress);
 
     // Only add forces from `atoms`
     for (int a = 0; a < atoms.size(); a++) {
-      Kuf_kernels[i].block(0, n_labels + n_energy + a * 3, n_sparse, 3) =
-          envs_struc_kernels.block(0, 1 + atoms[a] * 3, n_sparse, 3); // if n_energy=0, we can not use n_energy but 1
+      Kuf_i.block(0, n_labels + n_energy + a * 3, n_sparse_i, 3) =
+          envs_struc_kernels.block(0, 1 + atoms[a] * 3, n_sparse_i, 3); // if n_energy=0, we can not use n_energy but 1
     }
   }
 
@@ -566,10 +1119,10 @@ void SparseGP ::add_training_structure(const Structure &structure,
 
   // Store training structure.
   training_structures.push_back(structure);
+  if (compact_training)
+    training_structures.back().compress(sparse_descriptors);
   n_strucs += 1;
 
-  // Update Kuf.
-  stack_Kuf();
 }
 
 void SparseGP ::stack_Kuu() {
@@ -583,30 +1136,61 @@ void SparseGP ::stack_Kuu() {
   }
 }
 
-void SparseGP ::stack_Kuf() {
-  // Update Kuf kernels.
-  Kuf = Eigen::MatrixXd::Zero(n_sparse, n_labels);
-  int count = 0;
-  for (int i = 0; i < Kuf_kernels.size(); i++) {
-    int size = Kuf_kernels[i].rows();
-    Kuf.block(count, 0, size, n_labels) = Kuf_kernels[i];
-    count += size;
+Eigen::MatrixXd::RowsBlockXpr SparseGP ::Kuf_kernel(int i) {
+  int offset = 0;
+  for (int k = 0; k < i; k++) {
+    offset += sparse_descriptors[k].n_clusters;
   }
+  return Kuf.middleRows(offset, sparse_descriptors[i].n_clusters);
+}
+
+Eigen::MatrixXd::ConstRowsBlockXpr SparseGP ::Kuf_kernel(int i) const {
+  int offset = 0;
+  for (int k = 0; k < i; k++) {
+    offset += sparse_descriptors[k].n_clusters;
+  }
+  return Kuf.middleRows(offset, sparse_descriptors[i].n_clusters);
 }
 
 void SparseGP ::update_matrices_QR() {
+  // Find the sparse environments that have not been factored yet.
+  std::vector<bool> factored(n_sparse, false);
+  for (int i = 0; i < factor_indices.size(); i++) {
+    factored[factor_indices[i]] = true;
+  }
+  std::vector<int> new_indices;
+  for (int i = 0; i < n_sparse; i++) {
+    if (!factored[i])
+      new_indices.push_back(i);
+  }
+
+  // Refactor from scratch if the hyperparameters or jitter have changed, or
+  // if the new sparse block is too large for the Schur complement update to
+  // be reliable.
+  int n_old = factor_indices.size();
+  bool incremental = factors_current && (Kuu_jitter == factored_jitter) &&
+                     (n_old > 0) && (new_indices.size() <= n_old);
+
+  if (incremental && new_indices.size() > 0)
+    incremental = append_sparse_QR(new_indices);
+
+  if (incremental) {
+    append_labels_QR();
+  } else {
+    factor_matrices_QR();
+  }
+
+  solve_matrices_QR();
+}
+
+void SparseGP ::factor_matrices_QR() {
   // Store square root of noise vector.
   Eigen::VectorXd noise_vector_sqrt = sqrt(noise_vector.array());
 
   // Cholesky decompose Kuu.
   Eigen::LLT<Eigen::MatrixXd> chol(
       Kuu + Kuu_jitter * Eigen::MatrixXd::Identity(Kuu.rows(), Kuu.cols()));
-
-  // Get the inverse of Kuu from Cholesky decomposition.
-  Eigen::MatrixXd Kuu_eye = Eigen::MatrixXd::Identity(Kuu.rows(), Kuu.cols());
-  L_inv = chol.matrixL().solve(Kuu_eye);
-  L_diag = L_inv.diagonal();
-  Kuu_inverse = L_inv.transpose() * L_inv;
+  L_factor = chol.matrixL();
 
   // Form A matrix.
   Eigen::MatrixXd A =
@@ -621,13 +1205,225 @@ void SparseGP ::update_matrices_QR() {
 
   // QR decompose A.
   Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
-  Eigen::VectorXd Q_b = qr.householderQ().transpose() * b;
-  R_inv = qr.matrixQR().block(0, 0, Kuu.cols(), Kuu.cols())
-                       .triangularView<Eigen::Upper>()
-                       .solve(Kuu_eye);
-  R_inv_diag = R_inv.diagonal();
-  alpha = R_inv * Q_b;
+  Q_b = (qr.householderQ().transpose() * b).head(Kuu.cols());
+  R_factor = qr.matrixQR()
+                 .block(0, 0, Kuu.cols(), Kuu.cols())
+                 .triangularView<Eigen::Upper>();
+
+  // The factors are now in the same order as Kuu.
+  factor_indices.resize(n_sparse);
+  std::iota(factor_indices.begin(), factor_indices.end(), 0);
+  n_factored_labels = n_labels;
+  factored_jitter = Kuu_jitter;
+  factors_current = true;
+}
+
+bool SparseGP ::append_sparse_QR(const std::vector<int> &new_indices) {
+  // Append columns for new sparse environments to the factors. With
+  // R^T R = Kuu + Kuf N Kfu, the new columns follow from a Schur complement
+  // over the labels that have already been factored.
+  int n_old = factor_indices.size();
+  int n_new = new_indices.size();
+  int n_total = n_old + n_new;
+  int n_lab = n_factored_labels;
+
+  Eigen::MatrixXd Kuf_new(n_new, n_lab);
+  for (int i = 0; i < n_new; i++) {
+    Kuf_new.row(i) = Kuf.block(new_indices[i], 0, 1, n_lab);
+  }
+
+  Eigen::MatrixXd Kuu_old_new(n_old, n_new), Kuu_new_new(n_new, n_new);
+  for (int j = 0; j < n_new; j++) {
+    for (int i = 0; i < n_old; i++) {
+      Kuu_old_new(i, j) = Kuu(factor_indices[i], new_indices[j]);
+    }
+    for (int i = 0; i < n_new; i++) {
+      Kuu_new_new(i, j) = Kuu(new_indices[i], new_indices[j]);
+    }
+  }
+  Kuu_new_new += Kuu_jitter * Eigen::MatrixXd::Identity(n_new, n_new);
+
+  // Cholesky factor of Kuu.
+  Eigen::MatrixXd L_21 = L_factor.triangularView<Eigen::Lower>()
+                             .solve(Kuu_old_new)
+                             .transpose();
+  Eigen::LLT<Eigen::MatrixXd> chol_L(Kuu_new_new - L_21 * L_21.transpose());
+  if (chol_L.info() != Eigen::Success)
+    return false;
+
+  // Upper triangular factor of the A matrix.
+  // The product with the factored rows of Kuf is formed on Kuf in place and
+  // its rows gathered afterwards, so that Kuf is not copied.
+  Eigen::MatrixXd noise_Kfu_new =
+      noise_vector.head(n_lab).asDiagonal() * Kuf_new.transpose();
+  Eigen::MatrixXd Kuf_noise_Kfu_new = Kuf.leftCols(n_lab) * noise_Kfu_new;
+  Eigen::MatrixXd Kuf_old_noise_Kfu_new(n_old, n_new);
+  for (int i = 0; i < n_old; i++) {
+    Kuf_old_noise_Kfu_new.row(i) = Kuf_noise_Kfu_new.row(factor_indices[i]);
+  }
+  Eigen::MatrixXd R_12 =
+      R_factor.triangularView<Eigen::Upper>().transpose().solve(
+          Kuf_old_noise_Kfu_new + Kuu_old_new);
+  Eigen::LLT<Eigen::MatrixXd> chol_R(Kuf_new * noise_Kfu_new + Kuu_new_new -
+                                     R_12.transpose() * R_12);
+  if (chol_R.info() != Eigen::Success)
+    return false;
+  Eigen::MatrixXd R_22 = chol_R.matrixU();
+
+  // Q^T b restricted to the new columns.
+  Eigen::VectorXd Kuf_y =
+      noise_Kfu_new.transpose() * y.head(n_lab) - R_12.transpose() * Q_b;
+  Eigen::VectorXd Q_b_new =
+      R_22.triangularView<Eigen::Upper>().transpose().solve(Kuf_y);
+
+  L_factor.conservativeResize(n_total, n_total);
+  L_factor.block(0, n_old, n_old, n_new).setZero();
+  L_factor.block(n_old, 0, n_new, n_old) = L_21;
+  L_factor.block(n_old, n_old, n_new, n_new) = chol_L.matrixL();
+
+  R_factor.conservativeResize(n_total, n_total);
+  R_factor.block(n_old, 0, n_new, n_old).setZero();
+  R_factor.block(0, n_old, n_old, n_new) = R_12;
+  R_factor.block(n_old, n_old, n_new, n_new) = R_22;
+
+  Q_b.conservativeResize(n_total);
+  Q_b.tail(n_new) = Q_b_new;
+
+  factor_indices.insert(factor_indices.end(), new_indices.begin(),
+                        new_indices.end());
+  return true;
+}
+
+void SparseGP ::append_labels_QR() {
+  // Append rows for new labels to the A matrix and restore R to upper
+  // triangular form with one Householder reflection per column. Each
+  // reflection only touches row j of R and the new rows, so the cost is
+  // O(n_new_labels * n_sparse^2).
+  int n_new = n_labels - n_factored_labels;
+  if (n_new == 0)
+    return;
+  int n = factor_indices.size();
+
+  Eigen::VectorXd noise_sqrt =
+      sqrt(noise_vector.tail(n_new).array());
+  Eigen::MatrixXd W(n_new, n);
+  for (int i = 0; i < n; i++) {
+    W.col(i) = noise_sqrt.cwiseProduct(
+        Kuf.block(factor_indices[i], n_factored_labels, 1, n_new).transpose());
+  }
+  Eigen::VectorXd d = noise_sqrt.cwiseProduct(y.tail(n_new));
+
+  for (int j = 0; j < n; j++) {
+    double x0 = R_factor(j, j);
+    double tail_norm = W.col(j).squaredNorm();
+    if (tail_norm == 0)
+      continue;
+
+    double beta = sqrt(x0 * x0 + tail_norm);
+    if (x0 >= 0)
+      beta = -beta;
+    double tau = (beta - x0) / beta;
+    Eigen::VectorXd v = W.col(j) / (x0 - beta);
+
+    R_factor(j, j) = beta;
+    W.col(j).setZero();
+
+    int n_right = n - j - 1;
+    if (n_right > 0) {
+      Eigen::RowVectorXd s =
+          tau * (R_factor.row(j).tail(n_right) +
+                 v.transpose() * W.rightCols(n_right));
+      R_factor.row(j).tail(n_right) -= s;
+      W.rightCols(n_right).noalias() -= v * s;
+    }
+
+    double s_b = tau * (Q_b(j) + v.dot(d));
+    Q_b(j) -= s_b;
+    d -= s_b * v;
+  }
+
+  n_factored_labels = n_labels;
+}
+
+void SparseGP ::solve_matrices_QR() {
+  // Compute the solution attributes from the factors, and map them from
+  // factor order back to the order of Kuu.
+  int n = factor_indices.size();
+  Eigen::MatrixXd eye = Eigen::MatrixXd::Identity(n, n);
+
+  Eigen::MatrixXd R_inv_factor =
+      R_factor.triangularView<Eigen::Upper>().solve(eye);
+  Eigen::VectorXd alpha_factor =
+      R_factor.triangularView<Eigen::Upper>().solve(Q_b);
+
+  R_inv = Eigen::MatrixXd::Zero(n, n);
+  alpha = Eigen::VectorXd::Zero(n);
+  for (int i = 0; i < n; i++) {
+    int row = factor_indices[i];
+    R_inv.row(row) = R_inv_factor.row(i);
+    alpha(row) = alpha_factor(i);
+  }
+
+  // L_inv is the inverse of the Cholesky factor of Kuu in Kuu order, which
+  // is lower triangular (write_L_inverse only stores the lower triangle).
+  // Environments keep their relative order within a type block in factor
+  // order, so mapping the inverse of L_factor back preserves this as long as
+  // the cross-type blocks of Kuu vanish. Otherwise, once new environments
+  // have been appended out of Kuu order, Kuu is refactored in Kuu order.
+  bool in_order = true;
+  for (int i = 0; i < n; i++) {
+    if (factor_indices[i] != i)
+      in_order = false;
+  }
+  bool type_diagonal = true;
+  for (int i = 0; i < n_kernels; i++) {
+    if (!kernels[i]->type_diagonal())
+      type_diagonal = false;
+  }
+
+  if (in_order || type_diagonal) {
+    Eigen::MatrixXd L_inv_factor =
+        L_factor.triangularView<Eigen::Lower>().solve(eye);
+    L_inv = Eigen::MatrixXd::Zero(n, n);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j <= i; j++) {
+        L_inv(factor_indices[i], factor_indices[j]) = L_inv_factor(i, j);
+      }
+    }
+  } else {
+    Eigen::LLT<Eigen::MatrixXd> chol(Kuu + factored_jitter * eye);
+    L_inv = chol.matrixL().solve(eye);
+  }
+
+  L_diag = L_inv.diagonal();
+  R_inv_diag = R_inv_factor.diagonal();
+  Kuu_inverse = L_inv.transpose() * L_inv;
   Sigma = R_inv * R_inv.transpose();
+
+  // The solution no longer refers to a mapped model file.
+  mapped_arrays.clear();
+  mapped_file.reset();
+}
+
+Eigen::Map<const Eigen::MatrixXd>
+SparseGP ::solution_matrix(const std::string &name) const {
+  std::map<std::string, int>::const_iterator mapped = mapped_arrays.find(name);
+  if (mapped != mapped_arrays.end())
+    return mapped_file->matrix(mapped->second);
+
+  const Eigen::MatrixXd *matrix;
+  if (name == "Sigma")
+    matrix = &Sigma;
+  else if (name == "Kuu_inverse")
+    matrix = &Kuu_inverse;
+  else if (name == "R_inv")
+    matrix = &R_inv;
+  else if (name == "L_inv")
+    matrix = &L_inv;
+  else
+    throw std::invalid_argument("Unknown solution matrix " + name + ".");
+  return Eigen::Map<const Eigen::MatrixXd>(matrix->data(), matrix->rows(),
+                                           matrix->cols());
 }
 
 void SparseGP ::predict_mean(Structure &test_structure) {
@@ -664,7 +1460,8 @@ void SparseGP ::predict_SOR(Structure &test_structure) {
   }
 
   test_structure.mean_efs = kernel_mat.transpose() * alpha;
-  Eigen::MatrixXd variance_sqrt = kernel_mat.transpose() * R_inv;
+  Eigen::MatrixXd variance_sqrt =
+      kernel_mat.transpose() * solution_matrix("R_inv");
   test_structure.variance_efs =
       (variance_sqrt * variance_sqrt.transpose()).diagonal();
 }
@@ -694,8 +1491,10 @@ void SparseGP ::predict_DTC(Structure &test_structure) {
                                             kernels[i]->kernel_hyperparameters);
   }
 
-  Q_self = (kernel_mat.transpose() * Kuu_inverse * kernel_mat).diagonal();
-  V_SOR = (kernel_mat.transpose() * Sigma * kernel_mat).diagonal();
+  Q_self = (kernel_mat.transpose() * solution_matrix("Kuu_inverse") *
+            kernel_mat).diagonal();
+  V_SOR = (kernel_mat.transpose() * solution_matrix("Sigma") * kernel_mat)
+              .diagonal();
 
   test_structure.variance_efs = K_self - Q_self + V_SOR;
 }
@@ -722,12 +1521,102 @@ void SparseGP ::predict_local_uncertainties(Structure &test_structure) {
 
 }
 
-void SparseGP ::compute_likelihood_stable() {
-  // Compute inverse of Qff from Sigma.
-  Eigen::MatrixXd noise_diag = noise_vector.asDiagonal();
+Eigen::MatrixXd
+SparseGP ::batch_kernel_matrix(const std::vector<Structure *> &structures,
+                               std::vector<int> &column_offsets) {
 
-  data_fit =
-      -(1. / 2.) * y.transpose() * noise_diag * (y - Kuf.transpose() * alpha);
+  int n_strucs_batch = structures.size();
+  column_offsets = std::vector<int>(n_strucs_batch + 1, 0);
+  for (int s = 0; s < n_strucs_batch; s++) {
+    column_offsets[s + 1] =
+        column_offsets[s] + 1 + 3 * structures[s]->noa + 6;
+  }
+
+  Eigen::MatrixXd kernel_mat =
+      Eigen::MatrixXd::Zero(n_sparse, column_offsets[n_strucs_batch]);
+
+  // Each structure fills its own block of columns.
+#pragma omp parallel for schedule(dynamic)
+  for (int s = 0; s < n_strucs_batch; s++) {
+    int n_out = column_offsets[s + 1] - column_offsets[s];
+    int count = 0;
+    for (int i = 0; i < Kuu_kernels.size(); i++) {
+      int size = Kuu_kernels[i].rows();
+      kernel_mat.block(count, column_offsets[s], size, n_out) =
+          kernels[i]->envs_struc(sparse_descriptors[i],
+                                 structures[s]->descriptors[i],
+                                 kernels[i]->kernel_hyperparameters);
+      count += size;
+    }
+  }
+
+  return kernel_mat;
+}
+
+void SparseGP ::predict_mean_batch(std::vector<Structure *> structures) {
+  std::vector<int> offsets;
+  Eigen::MatrixXd kernel_mat = batch_kernel_matrix(structures, offsets);
+  Eigen::VectorXd mean = kernel_mat.transpose() * alpha;
+
+  for (int s = 0; s < structures.size(); s++) {
+    int n_out = offsets[s + 1] - offsets[s];
+    structures[s]->mean_efs = mean.segment(offsets[s], n_out);
+  }
+}
+
+void SparseGP ::predict_SOR_batch(std::vector<Structure *> structures) {
+  std::vector<int> offsets;
+  Eigen::MatrixXd kernel_mat = batch_kernel_matrix(structures, offsets);
+  Eigen::VectorXd mean = kernel_mat.transpose() * alpha;
+
+  // Only the diagonal of the predictive covariance is needed.
+  Eigen::MatrixXd variance_sqrt =
+      kernel_mat.transpose() * solution_matrix("R_inv");
+  Eigen::VectorXd variance = variance_sqrt.rowwise().squaredNorm();
+
+  for (int s = 0; s < structures.size(); s++) {
+    int n_out = offsets[s + 1] - offsets[s];
+    structures[s]->mean_efs = mean.segment(offsets[s], n_out);
+    structures[s]->variance_efs = variance.segment(offsets[s], n_out);
+  }
+}
+
+void SparseGP ::predict_DTC_batch(std::vector<Structure *> structures) {
+  std::vector<int> offsets;
+  Eigen::MatrixXd kernel_mat = batch_kernel_matrix(structures, offsets);
+  Eigen::VectorXd mean = kernel_mat.transpose() * alpha;
+
+  Eigen::MatrixXd kernel_T = kernel_mat.transpose();
+  Eigen::VectorXd Q_self =
+      (kernel_T * solution_matrix("Kuu_inverse"))
+          .cwiseProduct(kernel_T)
+          .rowwise()
+          .sum();
+  Eigen::VectorXd V_SOR = (kernel_T * solution_matrix("Sigma"))
+                              .cwiseProduct(kernel_T)
+                              .rowwise()
+                              .sum();
+
+#pragma omp parallel for schedule(dynamic)
+  for (int s = 0; s < structures.size(); s++) {
+    int n_out = offsets[s + 1] - offsets[s];
+    Eigen::VectorXd K_self = Eigen::VectorXd::Zero(n_out);
+    for (int i = 0; i < n_kernels; i++) {
+      K_self += kernels[i]->self_kernel_struc(
+          structures[s]->descriptors[i], kernels[i]->kernel_hyperparameters);
+    }
+
+    structures[s]->mean_efs = mean.segment(offsets[s], n_out);
+    structures[s]->variance_efs = K_self - Q_self.segment(offsets[s], n_out) +
+                                  V_SOR.segment(offsets[s], n_out);
+  }
+}
+
+void SparseGP ::compute_likelihood_stable() {
+  // The noise matrix is diagonal, so it is applied as an elementwise
+  // product with noise_vector.
+  Eigen::VectorXd y_K_alpha = y - Kuf.transpose() * alpha;
+  data_fit = -(1. / 2.) * y.dot(noise_vector.cwiseProduct(y_K_alpha));
   constant_term = -(1. / 2.) * n_labels * log(2 * M_PI);
 
   // Compute complexity penalty.
@@ -779,73 +1668,76 @@ double SparseGP ::compute_likelihood_gradient_stable(bool precomputed_KnK) {
   complexity_penalty = (1. / 2.) * (noise_det + Kuu_inv_det + sigma_inv_det);
   log_marginal_likelihood = complexity_penalty + data_fit + constant_term;
 
-  // Compute Kuu and Kuf matrices and gradients.
+  // Compute the gradients kernel by kernel. Kuu is block diagonal and the
+  // Kuf gradient of kernel i is only nonzero in the rows of its sparse
+  // environments, so only those blocks are formed. Traces of products of
+  // symmetric matrices are evaluated as elementwise sums,
+  // tr(A * B) = sum(A .* B), and the noise is applied as a diagonal scaling.
   int n_hyps_total = hyperparameters.size();
 
-  //Eigen::MatrixXd Kuu_mat = Eigen::MatrixXd::Zero(n_sparse, n_sparse);
-  //Eigen::MatrixXd Kuf_mat = Eigen::MatrixXd::Zero(n_sparse, n_labels);
-
-  std::vector<Eigen::MatrixXd> Kuu_grad, Kuf_grad, Kuu_grads, Kuf_grads;
+  std::vector<Eigen::MatrixXd> Kuu_grad, Kuf_grad;
+  std::vector<std::vector<Eigen::MatrixXd>> Kuf_grads;
+  if (!precomputed_KnK)
+    Kuf_grads = compute_Kuf_grads(hyperparameters);
 
-  int n_hyps, hyp_index = 0, grad_index = 0;
+  int n_hyps, hyp_index = 0;
   Eigen::VectorXd hyps_curr;
 
   int count = 0;
   Eigen::VectorXd complexity_grad = Eigen::VectorXd::Zero(n_hyps_total);
   Eigen::VectorXd datafit_grad = Eigen::VectorXd::Zero(n_hyps_total);
   likelihood_gradient = Eigen::VectorXd::Zero(n_hyps_total);
+  Eigen::VectorXd noise_y_K_alpha = noise_vector.cwiseProduct(y_K_alpha);
+  Eigen::MatrixXd noise_Kfu;
+  if (!precomputed_KnK)
+    noise_Kfu = noise_vector.asDiagonal() * Kuf.transpose();
   for (int i = 0; i < n_kernels; i++) {
     n_hyps = kernels[i]->kernel_hyperparameters.size();
     hyps_curr = hyperparameters.segment(hyp_index, n_hyps);
     int size = Kuu_kernels[i].rows();
 
     Kuu_grad = kernels[i]->Kuu_grad(sparse_descriptors[i], Kuu_kernels[i], hyps_curr);
-    if (!precomputed_KnK) { 
-      Kuf_grad = kernels[i]->Kuf_grad(sparse_descriptors[i], training_structures,
-                                      i, Kuf_kernels[i], hyps_curr);
-    }
+    if (!precomputed_KnK)
+      Kuf_grad = Kuf_grads[i];
 
-    //Kuu_mat.block(count, count, size, size) = Kuu_grad[0];
-    //Kuf_mat.block(count, 0, size, n_labels) = Kuf_grad[0];
-    Eigen::MatrixXd Kuu_i = Kuu_grad[0];
+    // Factor the Kuu block of this kernel once for all of its
+    // hyperparameters.
+    Eigen::LDLT<Eigen::MatrixXd> Kuu_i_ldlt(Kuu_grad[0]);
+    const Eigen::VectorXd alpha_i = alpha.segment(count, size);
+    const Eigen::MatrixXd Sigma_rows = Sigma.middleRows(count, size);
 
     for (int j = 0; j < n_hyps; j++) {
-      Kuu_grads.push_back(Eigen::MatrixXd::Zero(n_sparse, n_sparse));
-      Kuu_grads[hyp_index + j].block(count, count, size, size) =
-          Kuu_grad[j + 1];
-
-      if (!precomputed_KnK) { 
-        Kuf_grads.push_back(Eigen::MatrixXd::Zero(n_sparse, n_labels));
-        Kuf_grads[hyp_index + j].block(count, 0, size, n_labels) =
-            Kuf_grad[j + 1];
-      }
+      const Eigen::MatrixXd &dKuu = Kuu_grad[j + 1];
 
-      // Compute Pi matrix and save as an intermediate variable for derivative of complexity
+      // Rows of dKuf * noise * Kfu that belong to this kernel.
       Eigen::MatrixXd dK_noise_K;
       if (precomputed_KnK) {
-        dK_noise_K = compute_dKnK(i);
+        dK_noise_K = compute_dKnK(i).middleRows(count, size);
       } else {
-        Eigen::MatrixXd noise_diag = noise_vector.asDiagonal();
-        dK_noise_K = Kuf_grads[hyp_index + j] * noise_diag * Kuf.transpose();
+        dK_noise_K = Kuf_grad[j + 1] * noise_Kfu;
       }
-      Eigen::MatrixXd Pi_mat = dK_noise_K + dK_noise_K.transpose() + Kuu_grads[hyp_index + j]; 
 
-      // Derivative of complexity over sigma
+      // Derivative of complexity over sigma. With Pi = dK_noise_K +
+      // dK_noise_K^T + dKuu, tr(Pi * Sigma) only involves the rows and
+      // columns of this kernel.
       // TODO: the 2nd term is not very stable numerically, because dK_noise_K is very large, and Kuu_grads is small
-      complexity_grad(hyp_index + j) += 1./2. * (Kuu_i.inverse() * Kuu_grad[j + 1]).trace() - 1./2. * (Pi_mat * Sigma).trace(); 
+      double Pi_Sigma_trace =
+          2 * dK_noise_K.cwiseProduct(Sigma_rows).sum() +
+          dKuu.cwiseProduct(Sigma.block(count, count, size, size)).sum();
+      complexity_grad(hyp_index + j) +=
+          1./2. * Kuu_i_ldlt.solve(dKuu).trace() - 1./2. * Pi_Sigma_trace;
 
       // Derivative of data_fit over sigma
-      Eigen::VectorXd dK_alpha;
+      double dK_alpha_noise;
       if (precomputed_KnK) {
-        Eigen::MatrixXd dKuf = Eigen::MatrixXd::Zero(n_sparse, n_labels);
-        dKuf.block(count, 0, size, n_labels) = Kuf.block(count, 0, size, n_labels);
-        dK_alpha = (2. / hyps_curr(j)) * dKuf.transpose() * alpha;
+        dK_alpha_noise = (2. / hyps_curr(j)) *
+            alpha_i.dot(Kuf.middleRows(count, size) * noise_y_K_alpha);
       } else {
-        dK_alpha = Kuf_grads[hyp_index + j].transpose() * alpha;
+        dK_alpha_noise = alpha_i.dot(Kuf_grad[j + 1] * noise_y_K_alpha);
       }
 
-      datafit_grad(hyp_index + j) += dK_alpha.transpose() * noise_vector.cwiseProduct(y_K_alpha);
-      datafit_grad(hyp_index + j) += - 1./2. * alpha.transpose() * Kuu_grads[hyp_index + j] * alpha;
+      datafit_grad(hyp_index + j) += dK_alpha_noise;
+      datafit_grad(hyp_index + j) += - 1./2. * alpha_i.dot(dKuu * alpha_i);
 
       likelihood_gradient(hyp_index + j) += complexity_grad(hyp_index + j) + datafit_grad(hyp_index + j); 
     }
@@ -861,11 +1753,11 @@ double SparseGP ::compute_likelihood_gradient_stable(bool precomputed_KnK) {
   
   compute_KnK(precomputed_KnK);
   complexity_grad(hyp_index + 0) = - n_energy_labels / energy_noise 
-      + (KnK_e * Sigma).trace() / en3;
+      + KnK_e.cwiseProduct(Sigma).sum() / en3;
   complexity_grad(hyp_index + 1) = - n_force_labels / force_noise 
-      + (KnK_f * Sigma).trace() / fn3;
+      + KnK_f.cwiseProduct(Sigma).sum() / fn3;
   complexity_grad(hyp_index + 2) = - n_stress_labels / stress_noise 
-      + (KnK_s * Sigma).trace() / sn3;
+      + KnK_s.cwiseProduct(Sigma).sum() / sn3;
 
   // Derivative of data_fit over noise  
   datafit_grad(hyp_index + 0) = y_K_alpha.transpose() * e_noise_one.cwiseProduct(y_K_alpha);
@@ -900,9 +1792,9 @@ void SparseGP ::precompute_KnK() {
  
       double sig4 = hyps_i(0) * hyps_i(0) * hyps_j(0) * hyps_j(0);
   
-      Kuf_e_noise_Kfu.push_back(Kuf_kernels[i] * e_noise_one.asDiagonal() * Kuf_kernels[j].transpose() / sig4);
-      Kuf_f_noise_Kfu.push_back(Kuf_kernels[i] * f_noise_one.asDiagonal() * Kuf_kernels[j].transpose() / sig4);
-      Kuf_s_noise_Kfu.push_back(Kuf_kernels[i] * s_noise_one.asDiagonal() * Kuf_kernels[j].transpose() / sig4);
+      Kuf_e_noise_Kfu.push_back(Kuf_kernel(i) * e_noise_one.asDiagonal() * Kuf_kernel(j).transpose() / sig4);
+      Kuf_f_noise_Kfu.push_back(Kuf_kernel(i) * f_noise_one.asDiagonal() * Kuf_kernel(j).transpose() / sig4);
+      Kuf_s_noise_Kfu.push_back(Kuf_kernel(i) * s_noise_one.asDiagonal() * Kuf_kernel(j).transpose() / sig4);
     }
   }
 }
@@ -1025,6 +1917,9 @@ SparseGP ::compute_likelihood_gradient(const Eigen::VectorXd &hyperparameters) {
   int n_hyps, hyp_index = 0, grad_index = 0;
   Eigen::VectorXd hyps_curr;
 
+  std::vector<std::vector<Eigen::MatrixXd>> Kuf_grads_all =
+      compute_Kuf_grads(hyperparameters);
+
   int count = 0;
   for (int i = 0; i < n_kernels; i++) {
     n_hyps = kernels[i]->kernel_hyperparameters.size();
@@ -1032,8 +1927,7 @@ SparseGP ::compute_likelihood_gradient(const Eigen::VectorXd &hyperparameters) {
     int size = Kuu_kernels[i].rows();
 
     Kuu_grad = kernels[i]->Kuu_grad(sparse_descriptors[i], Kuu_kernels[i], hyps_curr);
-    Kuf_grad = kernels[i]->Kuf_grad(sparse_descriptors[i], training_structures,
-                                    i, Kuf_kernels[i], hyps_curr);
+    Kuf_grad = Kuf_grads_all[i];
 
     Kuu_mat.block(count, count, size, size) = Kuu_grad[0];
     Kuf_mat.block(count, 0, size, n_labels) = Kuf_grad[0];
@@ -1131,29 +2025,28 @@ void SparseGP ::set_hyperparameters(Eigen::VectorXd hyps) {
   int n_hyps, hyp_index = 0;
   Eigen::VectorXd new_hyps;
 
-  std::vector<Eigen::MatrixXd> Kuu_grad, Kuf_grad;
+  std::vector<Eigen::MatrixXd> Kuu_grad;
+  std::vector<std::vector<Eigen::MatrixXd>> Kuf_grads = compute_Kuf_grads(hyps);
   for (int i = 0; i < n_kernels; i++) {
     n_hyps = kernels[i]->kernel_hyperparameters.size();
     new_hyps = hyps.segment(hyp_index, n_hyps);
 
     Kuu_grad = kernels[i]->Kuu_grad(sparse_descriptors[i], Kuu_kernels[i], new_hyps);
-    Kuf_grad = kernels[i]->Kuf_grad(sparse_descriptors[i], training_structures,
-                                    i, Kuf_kernels[i], new_hyps);
 
     Kuu_kernels[i] = Kuu_grad[0];
-    Kuf_kernels[i] = Kuf_grad[0];
+    Kuf_kernel(i) = Kuf_grads[i][0];
 
     kernels[i]->set_hyperparameters(new_hyps);
     hyp_index += n_hyps;
   }
 
   stack_Kuu();
-  stack_Kuf();
 
   hyperparameters = hyps;
   energy_noise = hyps(hyp_index);
   force_noise = hyps(hyp_index + 1);
   stress_noise = hyps(hyp_index + 2);
+  factors_current = false;
 
   noise_vector = 1 / (energy_noise * energy_noise) * e_noise_one 
                + 1 / (force_noise * force_noise) * f_noise_one 
@@ -1163,6 +2056,15 @@ void SparseGP ::set_hyperparameters(Eigen::VectorXd hyps) {
   update_matrices_QR();
 }
 
+static Descriptor *descriptor_calculator(const SparseGP &sgp, int i) {
+  if (i >= sgp.descriptor_calculators.size() ||
+      sgp.descriptor_calculators[i] == nullptr)
+    throw std::runtime_error(
+        "The descriptor calculator of kernel " + std::to_string(i) +
+        " is not stored in the model, so its coefficients cannot be written.");
+  return sgp.descriptor_calculators[i];
+}
+
 void SparseGP::write_mapping_coefficients(std::string file_name,
                                           std::string contributor,
                                           int kernel_index) {
@@ -1190,8 +2092,8 @@ void SparseGP::write_mapping_coefficients(std::string file_name,
 
   // Write descriptor information to file.
   int coeff_size = mapping_coeffs.row(0).size();
-  training_structures[0].descriptor_calculators[kernel_index]->write_to_file(
-      coeff_file, coeff_size);
+  descriptor_calculator(*this, kernel_index)->write_to_file(coeff_file,
+                                                          coeff_size);
 
   // Write beta vectors to file.
   coeff_file << std::scientific << std::setprecision(16);
@@ -1264,7 +2166,7 @@ void SparseGP::write_varmap_coefficients(
 
   // Write descriptor information to file.
   int coeff_size = varmap_coeffs.row(0).size();
-  training_structures[0].descriptor_calculators[kernel_index]->
+  descriptor_calculator(*this, kernel_index)->
     write_to_file(coeff_file, coeff_size);
 
   // Write beta vectors to file.
@@ -1338,15 +2240,15 @@ void SparseGP::write_L_inverse(
   int sparse_count = 0;
   for (int i = 0; i < n_kernels; i++) {
     //  sparse_descriptors[i].descriptors[s];
-    training_structures[0].descriptor_calculators[i]->
+    descriptor_calculator(*this, i)->
       write_to_file(coeff_file, n_kernels);
 
     coeff_file << std::scientific << std::setprecision(16);
 
     // write the lower triangular part of L_inv_block 
     int n_clusters = sparse_descriptors[i].n_clusters;
-    Eigen::MatrixXd L_inverse_block =
-        L_inv.block(sparse_count, sparse_count, n_clusters, n_clusters);
+    Eigen::MatrixXd L_inverse_block = solution_matrix("L_inv").block(
+        sparse_count, sparse_count, n_clusters, n_clusters);
     sparse_count += n_clusters;
 
     coeff_file << n_clusters << "\n";
@@ -1431,6 +2333,95 @@ void SparseGP::write_sparse_descriptors(
   coeff_file.close();
 }
 
+void to_json(nlohmann::json &j, const SparseGP &sgp) {
+  j["hyperparameters"] = sgp.hyperparameters;
+  j["kernels"] = sgp.kernels;
+  j["Kuu_kernels"] = sgp.Kuu_kernels;
+  j["Kuu"] = sgp.Kuu;
+  j["Kuf"] = sgp.Kuf;
+  j["n_kernels"] = sgp.n_kernels;
+  j["Kuu_jitter"] = sgp.Kuu_jitter;
+  j["Sigma"] = sgp.solution_matrix("Sigma");
+  j["Kuu_inverse"] = sgp.solution_matrix("Kuu_inverse");
+  j["R_inv"] = sgp.solution_matrix("R_inv");
+  j["L_inv"] = sgp.solution_matrix("L_inv");
+  j["alpha"] = sgp.alpha;
+  j["R_inv_diag"] = sgp.R_inv_diag;
+  j["L_diag"] = sgp.L_diag;
+  j["sparse_descriptors"] = sgp.sparse_descriptors;
+  j["training_structures"] = sgp.training_structures;
+  j["descriptor_calculators"] = sgp.descriptor_calculators;
+  j["sparse_indices"] = sgp.sparse_indices;
+  j["noise_vector"] = sgp.noise_vector;
+  j["y"] = sgp.y;
+  j["label_count"] = sgp.label_count;
+  j["n_energy_labels"] = sgp.n_energy_labels;
+  j["n_force_labels"] = sgp.n_force_labels;
+  j["n_stress_labels"] = sgp.n_stress_labels;
+  j["n_sparse"] = sgp.n_sparse;
+  j["n_labels"] = sgp.n_labels;
+  j["n_strucs"] = sgp.n_strucs;
+  j["energy_noise"] = sgp.energy_noise;
+  j["force_noise"] = sgp.force_noise;
+  j["stress_noise"] = sgp.stress_noise;
+  j["log_marginal_likelihood"] = sgp.log_marginal_likelihood;
+  j["data_fit"] = sgp.data_fit;
+  j["complexity_penalty"] = sgp.complexity_penalty;
+  j["trace_term"] = sgp.trace_term;
+  j["constant_term"] = sgp.constant_term;
+  j["likelihood_gradient"] = sgp.likelihood_gradient;
+  j["compact_training"] = sgp.compact_training;
+  j["recompress_training"] = sgp.recompress_training;
+}
+
+void from_json(const nlohmann::json &j, SparseGP &sgp) {
+  j.at("hyperparameters").get_to(sgp.hyperparameters);
+  j.at("kernels").get_to(sgp.kernels);
+  j.at("Kuu_kernels").get_to(sgp.Kuu_kernels);
+  j.at("Kuu").get_to(sgp.Kuu);
+  j.at("Kuf").get_to(sgp.Kuf);
+  j.at("n_kernels").get_to(sgp.n_kernels);
+  j.at("Kuu_jitter").get_to(sgp.Kuu_jitter);
+  j.at("Sigma").get_to(sgp.Sigma);
+  j.at("Kuu_inverse").get_to(sgp.Kuu_inverse);
+  j.at("R_inv").get_to(sgp.R_inv);
+  j.at("L_inv").get_to(sgp.L_inv);
+  j.at("alpha").get_to(sgp.alpha);
+  j.at("R_inv_diag").get_to(sgp.R_inv_diag);
+  j.at("L_diag").get_to(sgp.L_diag);
+  j.at("sparse_descriptors").get_to(sgp.sparse_descriptors);
+  j.at("training_structures").get_to(sgp.training_structures);
+  // The calculators are shared with the training structures when they are
+  // loaded, and read from their own key otherwise (prediction-only models).
+  sgp.descriptor_calculators.clear();
+  if (sgp.training_structures.size() != 0)
+    sgp.descriptor_calculators =
+        sgp.training_structures[0].descriptor_calculators;
+  else if (j.contains("descriptor_calculators"))
+    j.at("descriptor_calculators").get_to(sgp.descriptor_calculators);
+  j.at("sparse_indices").get_to(sgp.sparse_indices);
+  j.at("noise_vector").get_to(sgp.noise_vector);
+  j.at("y").get_to(sgp.y);
+  j.at("label_count").get_to(sgp.label_count);
+  j.at("n_energy_labels").get_to(sgp.n_energy_labels);
+  j.at("n_force_labels").get_to(sgp.n_force_labels);
+  j.at("n_stress_labels").get_to(sgp.n_stress_labels);
+  j.at("n_sparse").get_to(sgp.n_sparse);
+  j.at("n_labels").get_to(sgp.n_labels);
+  j.at("n_strucs").get_to(sgp.n_strucs);
+  j.at("energy_noise").get_to(sgp.energy_noise);
+  j.at("force_noise").get_to(sgp.force_noise);
+  j.at("stress_noise").get_to(sgp.stress_noise);
+  j.at("log_marginal_likelihood").get_to(sgp.log_marginal_likelihood);
+  j.at("data_fit").get_to(sgp.data_fit);
+  j.at("complexity_penalty").get_to(sgp.complexity_penalty);
+  j.at("trace_term").get_to(sgp.trace_term);
+  j.at("constant_term").get_to(sgp.constant_term);
+  j.at("likelihood_gradient").get_to(sgp.likelihood_gradient);
+  sgp.compact_training = j.value("compact_training", false);
+  sgp.recompress_training = j.value("recompress_training", false);
+}
+
 void SparseGP ::to_json(std::string file_name, const SparseGP & sgp){
   std::ofstream sgp_file(file_name);
   nlohmann::json j = sgp;
@@ -1443,3 +2434,41 @@ SparseGP SparseGP ::from_json(std::string file_name){
   sgp_file >> j;
   return j;
 }
+
+void SparseGP ::to_binary(std::string file_name, const SparseGP & sgp){
+  flare_binary::write_binary(file_name, sgp);
+}
+
+SparseGP SparseGP ::from_binary(std::string file_name, bool prediction_only){
+  std::shared_ptr<flare_binary::ArrayReader> reader =
+      std::make_shared<flare_binary::ArrayReader>(file_name);
+  nlohmann::json &j = reader->metadata;
+  std::map<std::string, int> mapped;
+  if (prediction_only) {
+    // Files written before the descriptor calculators were stored apart
+    // hold them only in the training structures.
+    if (!j.contains("descriptor_calculators") &&
+        j.at("training_structures").size() != 0)
+      j["descriptor_calculators"] =
+          j["training_structures"][0].at("descriptor_calculators");
+    j["Kuf"] = nlohmann::json();
+    j["training_structures"] = nlohmann::json::array();
+
+    const char *solution_names[] = {"Sigma", "Kuu_inverse", "R_inv", "L_inv"};
+    for (const char *name : solution_names) {
+      if (!flare_binary::is_reference(j.at(name)))
+        continue;
+      mapped[name] =
+          flare_binary::referenced_array(j.at(name), flare_binary::float64)
+              .index;
+      j[name] = nlohmann::json::array();
+    }
+  }
+
+  SparseGP sgp = j;
+  if (!mapped.empty()) {
+    sgp.mapped_file = reader;
+    sgp.mapped_arrays = mapped;
+  }
+  return sgp;
+}
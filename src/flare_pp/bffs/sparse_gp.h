@@ -4,7 +4,10 @@
 #include "descriptor.h"
 #include "kernel.h"
 #include "structure.h"
+#include "binary.h"
 #include <Eigen/Dense>
+#include <map>
+#include <memory>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "json.h"
@@ -15,23 +18,90 @@ public:
 
   // Kernel attributes.
   std::vector<Kernel *> kernels;
-  std::vector<Eigen::MatrixXd> Kuu_kernels, Kuf_kernels;
+  std::vector<Eigen::MatrixXd> Kuu_kernels;
   Eigen::MatrixXd Kuu, Kuf;
+
   std::vector<Eigen::MatrixXd> Kuf_e_noise_Kfu, Kuf_f_noise_Kfu, Kuf_s_noise_Kfu;
   Eigen::MatrixXd KnK_e, KnK_f, KnK_s;
   int n_kernels = 0;
   double Kuu_jitter;
 
-  // Solution attributes.
+  // Hyperparameter-independent contractions between the sparse descriptors
+  // and the training structures (see Kernel::envs_struc_contractions),
+  // indexed by kernel and structure. They are computed on first use and
+  // cleared when sparse environments are added. The force contractions
+  // scale with the number of neighbors, so at most Kuf_contractions_limit
+  // bytes are cached; contractions beyond the limit are recomputed on each
+  // call. Set the limit to 0 to disable the cache.
+  std::vector<std::vector<std::vector<Eigen::MatrixXd>>> Kuf_contractions;
+  size_t Kuf_contractions_limit = size_t(1) << 30;
+  size_t Kuf_contractions_bytes = 0;
+  void clear_Kuf_contractions();
+
+  // Solution attributes. L_inv is the inverse of the lower Cholesky factor of
+  // Kuu + jitter in Kuu order, so it is lower triangular.
   Eigen::MatrixXd Sigma, Kuu_inverse, R_inv, L_inv;
   Eigen::VectorXd alpha, R_inv_diag, L_diag;
 
+  // Memory-mapped file of a model loaded with from_binary(file, true). The
+  // solution matrices named in mapped_arrays (Sigma, Kuu_inverse, R_inv and
+  // L_inv) are left empty and read from the file in place. The mapping is
+  // released when the solution is recomputed.
+  std::shared_ptr<const flare_binary::ArrayReader> mapped_file;
+  std::map<std::string, int> mapped_arrays;
+
+  // View of a solution matrix, from the mapped file if it was mapped and
+  // from the member of the same name otherwise.
+  Eigen::Map<const Eigen::MatrixXd>
+  solution_matrix(const std::string &name) const;
+
+  // Factorization state used to update the solution incrementally. The
+  // factors are stored in the order in which sparse environments were
+  // factored; factor_indices maps each factor column to its row in Kuu.
+  Eigen::MatrixXd R_factor, L_factor;
+  Eigen::VectorXd Q_b;
+  std::vector<int> factor_indices;
+  int n_factored_labels = 0;
+  double factored_jitter = 0;
+  bool factors_current = false;
+
+  // Descriptor calculators of each kernel, taken from the first structure
+  // passed to the model. They are stored apart from the training structures
+  // so that prediction-only models can still write mapping coefficients.
+  std::vector<Descriptor *> descriptor_calculators;
+
   // Training and sparse points.
   std::vector<ClusterDescriptor> sparse_descriptors;
   std::vector<Structure> training_structures;
   std::vector<std::vector<std::vector<int>>> sparse_indices;
   std::vector<std::vector<int>> training_atom_indices;
 
+  // Add call (index into sparse_indices[i]) and atom of each sparse
+  // environment, indexed by kernel in the order of sparse_descriptors. Used
+  // to update sparse_indices when environments are removed. Not serialized:
+  // the origins of environments added before the model was loaded are
+  // unknown (-1).
+  std::vector<std::vector<std::pair<int, int>>> sparse_origins;
+
+  // If true, training structures are stored without neighbor lists and with
+  // force derivatives compressed against the sparse set at the time they are
+  // added (see Structure::compress). Kernels with sparse environments added
+  // later are only exact if the environments lie in that span, which is
+  // rarely the case for environments of other frames. The first time a
+  // structure is reached by such an addition, update_Kuf recomputes its
+  // descriptors from its positions, which costs about as much as building
+  // the structure, and the structure is stored in full from then on.
+  // Compact training therefore saves memory when most sparse environments
+  // are selected before or together with the structures that use them.
+  //
+  // If recompress_training is also true, recomputed structures are instead
+  // compressed again against the enlarged sparse set. This keeps the memory
+  // low, but repeats the descriptor calculation of most training structures
+  // on every addition of sparse environments from a new frame, and the
+  // savings vanish once the sparse set spans the descriptor space.
+  bool compact_training = false;
+  bool recompress_training = false;
+
   // Label attributes.
   Eigen::VectorXd noise_vector, y, label_count, e_noise_one, f_noise_one, s_noise_one;
   Eigen::VectorXd inv_e_noise_one, inv_f_noise_one, inv_s_noise_one;
@@ -56,26 +126,93 @@ public:
                                  const std::vector<int> atoms);
   void add_random_environments(const Structure &structure,
                                const std::vector<int> &n_added);
+  // Add the n_added[i] clusters of the structure with the largest variance
+  // under kernel i. If diverse is true, the clusters are instead selected
+  // greedily by their variance conditioned on the clusters already selected
+  // (a pivoted Cholesky factorization), which skips near duplicates.
   void add_uncertain_environments(const Structure &structure,
-                                  const std::vector<int> &n_added);
+                                  const std::vector<int> &n_added,
+                                  bool diverse = false);
   std::vector<Eigen::VectorXd>
   compute_cluster_uncertainties(const Structure &structure);
+
+  // Variances of clusters under kernel i conditioned on the sparse set, given
+  // their kernels with the sparse environments (n_clusters x n_sparse_i).
+  // If projections is not null, it is set to L_inv * sparse_kernels^T.
+  Eigen::VectorXd
+  compute_cluster_variances(int i, const ClusterDescriptor &clusters,
+                            const Eigen::MatrixXd &sparse_kernels,
+                            Eigen::MatrixXd *projections = nullptr);
+  std::vector<int>
+  select_diverse_clusters(int i, const DescriptorValues &structure,
+                          const ClusterDescriptor &clusters,
+                          Eigen::VectorXd variances,
+                          const Eigen::MatrixXd &projections, int n_select);
   std::vector<std::vector<int>>
   sort_clusters_by_uncertainty(const Structure &structure);
+  void record_sparse_origins(int i, const DescriptorValues &structure,
+                             const std::vector<int> &clusters);
+
+  // Remove sparse environments, given for each kernel by their index in
+  // sparse_descriptors[i]. Kuu and Kuf are compacted, and the factors of the
+  // previous solution are downdated with Givens rotations, so that the next
+  // call to update_matrices_QR does not refactor from scratch.
+  void remove_sparse_environments(const std::vector<std::vector<int>> &removed);
+
+  // Remove near-duplicate sparse environments. An environment is redundant
+  // if its variance conditioned on the other sparse environments of its
+  // kernel is at most min_relative_variance times its prior variance. The
+  // most redundant environment is removed first, and the conditional
+  // variances of the others are updated before the next one is chosen.
+  // Returns the removed environments in the format of
+  // remove_sparse_environments.
+  std::vector<std::vector<int>>
+  prune_sparse_environments(double min_relative_variance);
 
   void add_training_structure(const Structure &structure, const std::vector<int> atom_indices = {-1}, double rel_e_noise = 1, double rel_f_noise = 1, double rel_s_noise = 1);
-  void update_Kuu(const std::vector<ClusterDescriptor> &cluster_descriptors);
+  // If given, sparse_blocks[i] holds the kernels between the sparse
+  // environments and the new clusters of kernel i.
+  void update_Kuu(const std::vector<ClusterDescriptor> &cluster_descriptors,
+                  const std::vector<Eigen::MatrixXd> &sparse_blocks = {});
   void update_Kuf(const std::vector<ClusterDescriptor> &cluster_descriptors);
   void stack_Kuu();
-  void stack_Kuf();
 
+  // Kuf is stored once, with the rows of each kernel stacked in kernel
+  // order. Kuf_kernel(i) is the block of rows that belongs to kernel i.
+  Eigen::MatrixXd::RowsBlockXpr Kuf_kernel(int i);
+  Eigen::MatrixXd::ConstRowsBlockXpr Kuf_kernel(int i) const;
+
+  // Kuf and its hyperparameter gradients for each kernel, in the format of
+  // Kernel::Kuf_grad. Kernels with cached contractions are evaluated in
+  // parallel over all kernel-structure pairs.
+  std::vector<std::vector<Eigen::MatrixXd>>
+  compute_Kuf_grads(const Eigen::VectorXd &hyperparameters);
+
+  // Update the solution attributes. The QR factor of the A matrix and the
+  // Cholesky factor of Kuu are updated in place when only new labels or a
+  // modest number of new sparse environments have been added since the last
+  // call; otherwise the factorization is recomputed from scratch.
   void update_matrices_QR();
+  void factor_matrices_QR();
+  bool append_sparse_QR(const std::vector<int> &new_indices);
+  void append_labels_QR();
+  void solve_matrices_QR();
 
   void predict_mean(Structure &structure);
   void predict_SOR(Structure &structure);
   void predict_DTC(Structure &structure);
   void predict_local_uncertainties(Structure &structure);
 
+  // Batched predictions. The kernel columns of all structures are computed in
+  // parallel and stacked into one matrix, so that the mean and variance of
+  // the whole batch follow from a single product with each solution matrix.
+  // Results are stored in the mean_efs and variance_efs of each structure.
+  Eigen::MatrixXd batch_kernel_matrix(const std::vector<Structure *> &structures,
+                                      std::vector<int> &column_offsets);
+  void predict_mean_batch(std::vector<Structure *> structures);
+  void predict_SOR_batch(std::vector<Structure *> structures);
+  void predict_DTC_batch(std::vector<Structure *> structures);
+
   void compute_likelihood_stable();
   double compute_likelihood_gradient_stable(bool precomputed_KnK = false);
   void precompute_KnK();
@@ -99,17 +236,23 @@ public:
   void write_L_inverse(std::string file_name, std::string contributor);
 
   // TODO: Make kernels jsonable.
-  NLOHMANN_DEFINE_TYPE_INTRUSIVE(SparseGP, hyperparameters, kernels,    
-    Kuu_kernels, Kuf_kernels, Kuu, Kuf, n_kernels, Kuu_jitter, Sigma,
-    Kuu_inverse, R_inv, L_inv, alpha, R_inv_diag, L_diag, sparse_descriptors,
-    training_structures, sparse_indices, noise_vector, y, label_count,
-    n_energy_labels, n_force_labels, n_stress_labels, n_sparse, n_labels,
-    n_strucs, energy_noise, force_noise, stress_noise, log_marginal_likelihood,
-    data_fit, complexity_penalty, trace_term, constant_term,
-    likelihood_gradient)
+  // Keys added after the first release (compact_training,
+  // recompress_training and descriptor_calculators) are optional when
+  // reading, so that older model files still load.
+  friend void to_json(nlohmann::json &j, const SparseGP &sgp);
+  friend void from_json(const nlohmann::json &j, SparseGP &sgp);
 
   static void to_json(std::string file_name, const SparseGP & sgp);
   static SparseGP from_json(std::string file_name);
+
+  // Binary model files (see binary.h). If prediction_only is true, Kuf and
+  // the training structures are not loaded, which leaves a model that can
+  // predict and write mapping coefficients but not be trained further, and
+  // the solution matrices are viewed in the mapped file instead of copied
+  // (see mapped_file).
+  static void to_binary(std::string file_name, const SparseGP & sgp);
+  static SparseGP from_binary(std::string file_name,
+                              bool prediction_only = false);
 };
 
 #endif
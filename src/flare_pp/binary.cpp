@@ -0,0 +1,260 @@
+#include "binary.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace flare_binary {
+
+namespace {
+thread_local ArrayWriter *writer_pointer = nullptr;
+
+// Subtype of the binary JSON values that hold resolved array views. JSON
+// text cannot contain binary values, and the reader rejects any found in
+// the stored metadata, so these are only created by resolve_references.
+const uint8_t view_subtype = 0x46;
+
+uint64_t align(uint64_t offset) {
+  return (offset + array_alignment - 1) / array_alignment * array_alignment;
+}
+
+uint64_t element_size(uint32_t type) {
+  return type == float64 ? sizeof(double) : sizeof(int32_t);
+}
+} // namespace
+
+ArrayWriter *active_writer() { return writer_pointer; }
+
+ScopedWriter::ScopedWriter(ArrayWriter *writer) : previous(writer_pointer) {
+  writer_pointer = writer;
+}
+ScopedWriter::~ScopedWriter() { writer_pointer = previous; }
+
+nlohmann::json ArrayWriter::add(const void *array_data, ArrayType type,
+                                int64_t rows, int64_t cols) {
+  ArrayEntry entry = {type, 0, rows, cols, 0};
+  entries.push_back(entry);
+  data.push_back(array_data);
+  return nlohmann::json{{"$array", entries.size() - 1}};
+}
+
+void ArrayWriter::write(const std::string &file_name,
+                        const nlohmann::json &metadata) {
+  std::vector<uint8_t> metadata_bytes = nlohmann::json::to_cbor(metadata);
+
+  // Lay out the table of contents, metadata and arrays.
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = format_version;
+  header.n_arrays = entries.size();
+  header.toc_offset = align(sizeof(FileHeader));
+  header.metadata_offset =
+      align(header.toc_offset + entries.size() * sizeof(ArrayEntry));
+  header.metadata_size = metadata_bytes.size();
+
+  uint64_t offset = align(header.metadata_offset + header.metadata_size);
+  for (int i = 0; i < entries.size(); i++) {
+    entries[i].offset = offset;
+    offset = align(offset + entries[i].rows * entries[i].cols *
+                                element_size(entries[i].type));
+  }
+  header.file_size = offset;
+
+  // Write to a temporary file that replaces the target at the end, so that
+  // a model mapped from the target stays valid.
+  std::string temp_name = file_name + ".tmp";
+  std::ofstream file(temp_name, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Could not open " + temp_name + " for writing.");
+
+  std::vector<char> padding(array_alignment, 0);
+  auto pad_to = [&](uint64_t target) {
+    uint64_t position = file.tellp();
+    file.write(padding.data(), target - position);
+  };
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  pad_to(header.toc_offset);
+  file.write(reinterpret_cast<const char *>(entries.data()),
+             entries.size() * sizeof(ArrayEntry));
+  pad_to(header.metadata_offset);
+  file.write(reinterpret_cast<const char *>(metadata_bytes.data()),
+             metadata_bytes.size());
+  for (int i = 0; i < entries.size(); i++) {
+    pad_to(entries[i].offset);
+    file.write(reinterpret_cast<const char *>(data[i]),
+               entries[i].rows * entries[i].cols *
+                   element_size(entries[i].type));
+  }
+  pad_to(header.file_size);
+
+  file.close();
+  if (!file || std::rename(temp_name.c_str(), file_name.c_str()) != 0)
+    throw std::runtime_error("Could not write " + file_name + ".");
+}
+
+ArrayReader::ArrayReader(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open " + file_name + ".");
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    throw std::runtime_error("Could not read the size of " + file_name + ".");
+  }
+  mapped_size = file_stat.st_size;
+  if (mapped_size < sizeof(FileHeader)) {
+    close(fd);
+    throw std::runtime_error(file_name + " is not a FLARE binary file.");
+  }
+
+  void *address = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("Could not map " + file_name + ".");
+  mapped = static_cast<const char *>(address);
+
+  try {
+    validate(file_name);
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(mapped);
+    const uint8_t *metadata_start =
+        reinterpret_cast<const uint8_t *>(mapped + header->metadata_offset);
+    metadata = nlohmann::json::from_cbor(
+        metadata_start, metadata_start + header->metadata_size);
+    resolve_references(metadata);
+  } catch (...) {
+    munmap(const_cast<char *>(mapped), mapped_size);
+    mapped = nullptr;
+    throw;
+  }
+}
+
+void ArrayReader::validate(const std::string &file_name) {
+  const FileHeader *header = reinterpret_cast<const FileHeader *>(mapped);
+  if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+      header->file_size != mapped_size)
+    throw std::runtime_error(file_name + " is not a FLARE binary file.");
+  if (header->version != format_version)
+    throw std::runtime_error(file_name +
+                             " was written with an unsupported version.");
+
+  // Every offset is checked before it is added to, so that corrupt values
+  // cannot overflow.
+  std::string corrupt = file_name + " is corrupt: ";
+  if (header->toc_offset < sizeof(FileHeader) ||
+      header->toc_offset > mapped_size ||
+      header->toc_offset % array_alignment != 0)
+    throw std::runtime_error(corrupt + "bad table of contents offset.");
+  if (header->n_arrays > (mapped_size - header->toc_offset) /
+                             sizeof(ArrayEntry))
+    throw std::runtime_error(corrupt + "table of contents out of bounds.");
+  if (header->metadata_offset > mapped_size ||
+      header->metadata_size > mapped_size - header->metadata_offset)
+    throw std::runtime_error(corrupt + "metadata out of bounds.");
+
+  toc = reinterpret_cast<const ArrayEntry *>(mapped + header->toc_offset);
+  n_entries = header->n_arrays;
+
+  for (int i = 0; i < n_entries; i++) {
+    const ArrayEntry &array_entry = toc[i];
+    if (array_entry.type != float64 && array_entry.type != int32)
+      throw std::runtime_error(corrupt + "unknown array type.");
+    if (array_entry.rows < 0 || array_entry.cols < 0)
+      throw std::runtime_error(corrupt + "negative array size.");
+    if (array_entry.offset > mapped_size ||
+        array_entry.offset % array_alignment != 0)
+      throw std::runtime_error(corrupt + "bad array offset.");
+
+    uint64_t available =
+        (mapped_size - array_entry.offset) / element_size(array_entry.type);
+    uint64_t rows = array_entry.rows, cols = array_entry.cols;
+    if (rows != 0 && cols > available / rows)
+      throw std::runtime_error(corrupt + "array out of bounds.");
+  }
+}
+
+void ArrayReader::resolve_references(nlohmann::json &j) const {
+  if (j.is_binary())
+    throw std::runtime_error("Unexpected binary value in the metadata.");
+
+  if (is_reference(j)) {
+    int index = j.at("$array").get<int>();
+    const ArrayEntry &array_entry = entry(index);
+    ArrayView view = {array_data(index), array_entry.type, array_entry.rows,
+                      array_entry.cols, index};
+
+    std::vector<uint8_t> bytes(sizeof(ArrayView));
+    std::memcpy(bytes.data(), &view, sizeof(ArrayView));
+    j["$view"] = nlohmann::json::binary(bytes, view_subtype);
+    return;
+  }
+
+  if (j.is_structured()) {
+    for (nlohmann::json &child : j)
+      resolve_references(child);
+  }
+}
+
+ArrayReader::~ArrayReader() {
+  if (mapped != nullptr)
+    munmap(const_cast<char *>(mapped), mapped_size);
+}
+
+int ArrayReader::n_arrays() const { return n_entries; }
+
+const ArrayEntry &ArrayReader::entry(int index) const {
+  if (index < 0 || index >= n_entries)
+    throw std::out_of_range("Array index out of range.");
+  return toc[index];
+}
+
+const void *ArrayReader::array_data(int index) const {
+  return mapped + entry(index).offset;
+}
+
+Eigen::Map<const Eigen::MatrixXd> ArrayReader::matrix(int index) const {
+  const ArrayEntry &array_entry = entry(index);
+  if (array_entry.type != float64)
+    throw std::runtime_error("Array is not of type float64.");
+  return Eigen::Map<const Eigen::MatrixXd>(
+      static_cast<const double *>(array_data(index)), array_entry.rows,
+      array_entry.cols);
+}
+
+Eigen::Map<const Eigen::VectorXi> ArrayReader::vector_int(int index) const {
+  const ArrayEntry &array_entry = entry(index);
+  if (array_entry.type != int32)
+    throw std::runtime_error("Array is not of type int32.");
+  return Eigen::Map<const Eigen::VectorXi>(
+      static_cast<const int *>(array_data(index)),
+      array_entry.rows * array_entry.cols);
+}
+
+bool is_reference(const nlohmann::json &j) {
+  return j.is_object() && j.contains("$array");
+}
+
+ArrayView referenced_array(const nlohmann::json &reference, ArrayType type) {
+  const nlohmann::json *resolved = nullptr;
+  if (reference.contains("$view"))
+    resolved = &reference.at("$view");
+  if (resolved == nullptr || !resolved->is_binary() ||
+      resolved->get_binary().subtype() != view_subtype ||
+      resolved->get_binary().size() != sizeof(ArrayView))
+    throw std::runtime_error("Array reference found outside a binary read.");
+
+  ArrayView view;
+  std::memcpy(&view, resolved->get_binary().data(), sizeof(ArrayView));
+  if (view.type != type)
+    throw std::runtime_error("Array type does not match the stored type.");
+  return view;
+}
+
+} // namespace flare_binary
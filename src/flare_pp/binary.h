@@ -0,0 +1,137 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Binary model container.
+//
+// The file starts with a fixed-size header, followed by a table of contents
+// with one entry per array, a CBOR-encoded metadata document, and the raw
+// arrays themselves. Each array is stored in column-major order at an offset
+// aligned to array_alignment bytes, so that a memory-mapped file can be
+// viewed directly with Eigen::Map.
+//
+// The metadata document is the JSON form of the object (see json.h), with
+// every Eigen matrix or vector replaced by a reference {"$array": index}
+// into the table of contents.
+namespace flare_binary {
+
+const char magic[8] = {'F', 'L', 'A', 'R', 'E', 'B', 'I', 'N'};
+const uint32_t format_version = 1;
+const uint64_t array_alignment = 64;
+
+enum ArrayType : uint32_t { float64 = 0, int32 = 1 };
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t n_arrays;
+  uint64_t toc_offset;
+  uint64_t metadata_offset;
+  uint64_t metadata_size;
+  uint64_t file_size;
+  uint64_t reserved[2];
+};
+
+struct ArrayEntry {
+  uint32_t type;
+  uint32_t reserved;
+  int64_t rows;
+  int64_t cols;
+  uint64_t offset;
+};
+
+// Collects the arrays of an object while it is converted to JSON.
+class ArrayWriter {
+public:
+  std::vector<ArrayEntry> entries;
+  std::vector<const void *> data;
+
+  nlohmann::json add(const void *array_data, ArrayType type, int64_t rows,
+                     int64_t cols);
+  void write(const std::string &file_name, const nlohmann::json &metadata);
+};
+
+// Location and shape of an array in a mapped container.
+struct ArrayView {
+  const void *data;
+  uint32_t type;
+  int64_t rows;
+  int64_t cols;
+  int index;
+};
+
+// Read-only, memory-mapped view of a binary container. The header, table of
+// contents and array extents are checked against the size of the file when
+// it is opened. Every array reference in the metadata is then resolved in
+// place, so that the Eigen serializers in json.h can read the arrays without
+// access to the reader. The reader must outlive any Eigen::Map views of its
+// arrays.
+class ArrayReader {
+public:
+  nlohmann::json metadata;
+
+  ArrayReader(const std::string &file_name);
+  ~ArrayReader();
+
+  int n_arrays() const;
+  const ArrayEntry &entry(int index) const;
+  const void *array_data(int index) const;
+
+  // Zero-copy views of the stored arrays.
+  Eigen::Map<const Eigen::MatrixXd> matrix(int index) const;
+  Eigen::Map<const Eigen::VectorXi> vector_int(int index) const;
+
+private:
+  const char *mapped = nullptr;
+  size_t mapped_size = 0;
+  const ArrayEntry *toc = nullptr;
+  int n_entries = 0;
+
+  void validate(const std::string &file_name);
+  void resolve_references(nlohmann::json &j) const;
+
+  ArrayReader(const ArrayReader &);
+  ArrayReader &operator=(const ArrayReader &);
+};
+
+// Archive used by the Eigen serializers in json.h while an object is
+// converted for a binary write. nlohmann's to_json takes no context
+// argument, so the writer is installed for the duration of the conversion
+// on the calling thread; the previous writer is restored afterwards.
+ArrayWriter *active_writer();
+
+class ScopedWriter {
+public:
+  ScopedWriter(ArrayWriter *writer);
+  ~ScopedWriter();
+
+private:
+  ArrayWriter *previous;
+};
+
+// View of the array referenced by a metadata entry of an ArrayReader,
+// checking its type.
+ArrayView referenced_array(const nlohmann::json &reference, ArrayType type);
+
+bool is_reference(const nlohmann::json &j);
+
+// Write any object that has a JSON representation to a binary container.
+template <typename T>
+void write_binary(const std::string &file_name, const T &object) {
+  ArrayWriter writer;
+  nlohmann::json metadata;
+  {
+    ScopedWriter scope(&writer);
+    metadata = object;
+  }
+  writer.write(file_name, metadata);
+}
+
+} // namespace flare_binary
+
+#endif
@@ -28,6 +28,8 @@ B2 ::B2(const std::string &radial_basis, const std::string &cutoff_function,
   int n_species = descriptor_settings[0];
   double cutoff_val = radial_hyps[1];
   cutoffs = Eigen::MatrixXd::Constant(n_species, n_species, cutoff_val);
+
+  build_radial_tables();
 }
 
 B2 ::B2(const std::string &radial_basis, const std::string &cutoff_function,
@@ -47,6 +49,27 @@ B2 ::B2(const std::string &radial_basis, const std::string &cutoff_function,
 
   // Assign cutoff matrix.
   this->cutoffs = cutoffs;
+
+  build_radial_tables();
+}
+
+void B2 ::build_radial_tables() {
+  int n_species = descriptor_settings[0];
+  int N = descriptor_settings[1];
+
+  double r_min = radial_basis_min(radial_basis, radial_hyps);
+
+  radial_tables.clear();
+  std::vector<double> new_radial_hyps = radial_hyps;
+  for (int i = 0; i < n_species; i++) {
+    for (int j = 0; j < n_species; j++) {
+      double rcut = cutoffs(i, j);
+      new_radial_hyps[1] = rcut;
+      radial_tables.push_back(RadialTable(radial_pointer, cutoff_pointer,
+                                          r_min, rcut, N, new_radial_hyps,
+                                          cutoff_hyps));
+    }
+  }
 }
 
 void B2 ::write_to_file(std::ofstream &coeff_file, int coeff_size) {
@@ -91,7 +114,7 @@ DescriptorValues B2 ::compute_struc(Structure &structure) {
     single_bond_vals, force_dervs, neighbor_coords, unique_neighbor_count,
     cumulative_neighbor_count, descriptor_indices, radial_pointer,
     cutoff_pointer, nos, N, lmax, radial_hyps, cutoff_hyps, structure,
-    cutoffs);
+    cutoffs, radial_tables);
 
   // Compute descriptor values.
   Eigen::MatrixXd B2_vals, B2_force_dervs;
@@ -178,6 +201,30 @@ DescriptorValues B2 ::compute_struc(Structure &structure) {
   return desc;
 }
 
+// On x86-64 Linux, the inner derivative loop is compiled for AVX-512, AVX2 and
+// the baseline instruction set, and the best version is selected at load
+// time. FMA contraction is disabled and the loop only vectorizes across rows,
+// so every clone gives the same result as the scalar loop.
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) &&          \
+    !defined(__clang__)
+#define B2_TARGET_CLONES                                                       \
+  __attribute__((target_clones("avx512f", "avx2", "default"),                  \
+                 optimize("fp-contract=off")))
+#else
+#define B2_TARGET_CLONES
+#endif
+
+B2_TARGET_CLONES
+static void accumulate_b2_dervs(double *__restrict dervs,
+                         const double *__restrict dervs_1,
+                         const double *__restrict dervs_2, double val_1,
+                         double val_2, int n_rows) {
+#pragma omp simd
+  for (int i = 0; i < n_rows; i++) {
+    dervs[i] += val_1 * dervs_2[i] + dervs_1[i] * val_2;
+  }
+}
+
 void compute_b2(Eigen::MatrixXd &B2_vals, Eigen::MatrixXd &B2_force_dervs,
                 Eigen::VectorXd &B2_norms, Eigen::VectorXd &B2_force_dots,
                 const Eigen::MatrixXd &single_bond_vals,
@@ -200,31 +247,40 @@ void compute_b2(Eigen::MatrixXd &B2_vals, Eigen::MatrixXd &B2_force_dervs,
   B2_norms = Eigen::VectorXd::Zero(n_atoms);
   B2_force_dots = Eigen::VectorXd::Zero(n_neighbors * 3);
 
+  // The force derivatives of an atom occupy a contiguous run of rows in each
+  // column of the column-major derivative matrices, so each (n1, n2, l, m)
+  // term is accumulated as one vectorized pass over the atom's neighbors.
+  int bond_stride = single_bond_force_dervs.rows();
+  int derv_stride = B2_force_dervs.rows();
+
 #pragma omp parallel for
   for (int atom = 0; atom < n_atoms; atom++) {
     int n_atom_neighbors = unique_neighbor_count(atom);
     int force_start = cumulative_neighbor_count(atom) * 3;
-    int n1, n2, l, m, n1_l, n2_l;
+    int n_rows = n_atom_neighbors * 3;
+
+    // Copy the single bond values of the atom to contiguous storage.
+    Eigen::VectorXd bond_vals = single_bond_vals.row(atom).transpose();
+    const double *bond_dervs = single_bond_force_dervs.data() + force_start;
+    double *dervs = B2_force_dervs.data() + force_start;
+
+    int n1_l, n2_l;
     int counter = 0;
     for (int n1 = 0; n1 < n_radial; n1++) {
-      for (int n2 = n1; n2 < n_radial; n2++) { // can be simplified
+      for (int n2 = n1; n2 < n_radial; n2++) {
         for (int l = 0; l < (lmax + 1); l++) {
+          double *dervs_counter = dervs + (size_t)counter * derv_stride;
           for (int m = 0; m < (2 * l + 1); m++) {
             n1_l = n1 * n_harmonics + (l * l + m);
             n2_l = n2 * n_harmonics + (l * l + m);
-            B2_vals(atom, counter) +=
-                single_bond_vals(atom, n1_l) * single_bond_vals(atom, n2_l);
+            B2_vals(atom, counter) += bond_vals(n1_l) * bond_vals(n2_l);
 
             // Store force derivatives.
-            for (int n = 0; n < n_atom_neighbors; n++) {
-              for (int comp = 0; comp < 3; comp++) {
-                int ind = force_start + n * 3 + comp;
-                B2_force_dervs(ind, counter) +=
-                    single_bond_vals(atom, n1_l) *
-                        single_bond_force_dervs(ind, n2_l) +
-                    single_bond_force_dervs(ind, n1_l) *
-                        single_bond_vals(atom, n2_l);
-              }
+            if (n_rows > 0) {
+              accumulate_b2_dervs(dervs_counter,
+                                  bond_dervs + (size_t)n1_l * bond_stride,
+                                  bond_dervs + (size_t)n2_l * bond_stride,
+                                  bond_vals(n1_l), bond_vals(n2_l), n_rows);
             }
           }
           counter++;
@@ -254,7 +310,8 @@ void single_bond_multiple_cutoffs(
         cutoff_function,
     int nos, int N, int lmax, const std::vector<double> &radial_hyps,
     const std::vector<double> &cutoff_hyps, const Structure &structure,
-    const Eigen::MatrixXd &cutoffs) {
+    const Eigen::MatrixXd &cutoffs,
+    const std::vector<RadialTable> &radial_tables) {
 
   int n_atoms = structure.noa;
   int n_neighbors = structure.n_neighbors;
@@ -328,14 +385,30 @@ void single_bond_multiple_cutoffs(
     std::vector<double> gy = std::vector<double>(N, 0);
     std::vector<double> gz = std::vector<double>(N, 0);
 
-    std::vector<double> h = std::vector<double>(number_of_harmonics, 0);
-    std::vector<double> hx = std::vector<double>(number_of_harmonics, 0);
-    std::vector<double> hy = std::vector<double>(number_of_harmonics, 0);
-    std::vector<double> hz = std::vector<double>(number_of_harmonics, 0);
+    // Store the coordinates of the neighbors inside the cutoff, and compute
+    // their spherical harmonics as one batch.
+    int n_inside = neighbor_count(i);
+    for (int j = 0, inside = neighbor_index; j < i_neighbors; j++) {
+      int neigh_index = rel_index + j;
+      int neighbor_species = structure.neighbor_species(neigh_index);
+      if (structure.relative_positions(neigh_index, 0) >
+          cutoffs(central_species, neighbor_species))
+        continue;
+      neighbor_coordinates.row(inside) =
+          structure.relative_positions.block(neigh_index, 1, 1, 3);
+      inside++;
+    }
+
+    Eigen::MatrixXd h, hx, hy, hz;
+    Eigen::MatrixXd coords = neighbor_coordinates.block(neighbor_index, 0,
+                                                        n_inside, 3);
+    get_Y_batch(h, hx, hy, hz, coords.col(0), coords.col(1), coords.col(2),
+                lmax);
 
     double x, y, z, r, bond, bond_x, bond_y, bond_z, g_val, gx_val, gy_val,
         gz_val, h_val;
     int s, neigh_index, descriptor_counter, unique_ind;
+    int local_index = 0;
     for (int j = 0; j < i_neighbors; j++) {
       neigh_index = rel_index + j;
       int neighbor_species = structure.neighbor_species(neigh_index);
@@ -351,15 +424,15 @@ void single_bond_multiple_cutoffs(
       // Reset the endpoint of the radial basis set.
       new_radial_hyps[1] = rcut;
 
-      // Store neighbor coordinates.
-      neighbor_coordinates(neighbor_index, 0) = x;
-      neighbor_coordinates(neighbor_index, 1) = y;
-      neighbor_coordinates(neighbor_index, 2) = z;
-
-      // Compute radial basis values and spherical harmonics.
-      calculate_radial(g, gx, gy, gz, radial_function, cutoff_function, x, y, z,
-                       r, rcut, N, new_radial_hyps, cutoff_hyps);
-      get_Y(h, hx, hy, hz, x, y, z, lmax);
+      // Compute radial basis values.
+      if (radial_tables.size() > 0) {
+        radial_tables[central_species * nos + neighbor_species]
+            .calculate_radial(g.data(), gx.data(), gy.data(), gz.data(), x, y,
+                              z, r);
+      } else {
+        calculate_radial(g, gx, gy, gz, radial_function, cutoff_function, x,
+                         y, z, r, rcut, N, new_radial_hyps, cutoff_hyps);
+      }
 
       // Store the products and their derivatives.
       descriptor_counter = s * no_bond_vals;
@@ -375,13 +448,13 @@ void single_bond_multiple_cutoffs(
              angular_counter++) {
 
           // Compute single bond value.
-          h_val = h[angular_counter];
+          h_val = h(local_index, angular_counter);
           bond = g_val * h_val;
 
           // Calculate derivatives with the product rule.
-          bond_x = gx_val * h_val + g_val * hx[angular_counter];
-          bond_y = gy_val * h_val + g_val * hy[angular_counter];
-          bond_z = gz_val * h_val + g_val * hz[angular_counter];
+          bond_x = gx_val * h_val + g_val * hx(local_index, angular_counter);
+          bond_y = gy_val * h_val + g_val * hy(local_index, angular_counter);
+          bond_z = gz_val * h_val + g_val * hz(local_index, angular_counter);
 
           // Update single bond arrays.
           single_bond_vals(i, descriptor_counter) += bond;
@@ -394,6 +467,7 @@ void single_bond_multiple_cutoffs(
         }
       }
       neighbor_index++;
+      local_index++;
     }
   }
 }
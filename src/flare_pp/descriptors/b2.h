@@ -2,6 +2,7 @@
 #define B2_H
 
 #include "descriptor.h"
+#include "radial.h"
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
@@ -29,6 +30,11 @@ public:
    */
   Eigen::MatrixXd cutoffs;
 
+  /** Spline tables of the radial basis for each pair of species (see
+   * RadialTable), indexed by central species * n_species + neighbor species.
+   */
+  std::vector<RadialTable> radial_tables;
+
   B2();
 
   B2(const std::string &radial_basis, const std::string &cutoff_function,
@@ -45,6 +51,8 @@ public:
      const std::vector<int> &descriptor_settings,
      const Eigen::MatrixXd &cutoffs);
 
+  void build_radial_tables();
+
   DescriptorValues compute_struc(Structure &structure);
 
   void write_to_file(std::ofstream &coeff_file, int coeff_size);
@@ -78,7 +86,8 @@ void single_bond_multiple_cutoffs(
         cutoff_function,
     int nos, int N, int lmax, const std::vector<double> &radial_hyps,
     const std::vector<double> &cutoff_hyps, const Structure &structure,
-    const Eigen::MatrixXd &cutoffs);
+    const Eigen::MatrixXd &cutoffs,
+    const std::vector<RadialTable> &radial_tables = {});
 
 /**
  * TODO: Update other descriptors to call the multi-cutoff version
@@ -1,4 +1,5 @@
 #include "b3.h"
+#include "b2.h"
 #include "cutoffs.h"
 #include "descriptor.h"
 #include "radial.h"
@@ -20,7 +21,7 @@ B3 ::B3(const std::string &radial_basis, const std::string &cutoff_function,
   this->cutoff_hyps = cutoff_hyps;
   this->descriptor_settings = descriptor_settings;
 
-  wigner3j_coeffs = compute_coeffs(descriptor_settings[2]);
+  wigner3j_terms = get_wigner3j_terms(descriptor_settings[2], true);
 
   set_radial_basis(radial_basis, this->radial_pointer);
   set_cutoff(cutoff_function, this->cutoff_pointer);
@@ -32,7 +33,7 @@ DescriptorValues B3 ::compute_struc(Structure &structure) {
   DescriptorValues desc = DescriptorValues();
 
   // Compute single bond values.
-  Eigen::MatrixXcd single_bond_vals, force_dervs;
+  Eigen::MatrixXd single_bond_vals, force_dervs;
   Eigen::MatrixXd neighbor_coords;
   Eigen::VectorXi unique_neighbor_count, cumulative_neighbor_count,
       descriptor_indices;
@@ -41,7 +42,7 @@ DescriptorValues B3 ::compute_struc(Structure &structure) {
   int N = descriptor_settings[1];
   int lmax = descriptor_settings[2];
 
-  complex_single_bond(single_bond_vals, force_dervs, neighbor_coords,
+  compute_single_bond(single_bond_vals, force_dervs, neighbor_coords,
                       unique_neighbor_count, cumulative_neighbor_count,
                       descriptor_indices, radial_pointer, cutoff_pointer, nos,
                       N, lmax, radial_hyps, cutoff_hyps, structure);
@@ -52,7 +53,7 @@ DescriptorValues B3 ::compute_struc(Structure &structure) {
 
   compute_B3(B3_vals, B3_force_dervs, B3_norms, B3_force_dots, single_bond_vals,
              force_dervs, unique_neighbor_count, cumulative_neighbor_count,
-             descriptor_indices, nos, N, lmax, wigner3j_coeffs);
+             descriptor_indices, nos, N, lmax, *wigner3j_terms);
 
   // Gather species information.
   int noa = structure.noa;
@@ -131,32 +132,25 @@ DescriptorValues B3 ::compute_struc(Structure &structure) {
   return desc;
 }
 
-void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
-                Eigen::VectorXd &B3_norms, Eigen::VectorXd &B3_force_dots,
-                const Eigen::MatrixXcd &single_bond_vals,
-                const Eigen::MatrixXcd &single_bond_force_dervs,
-                const Eigen::VectorXi &unique_neighbor_count,
-                const Eigen::VectorXi &cumulative_neighbor_count,
-                const Eigen::VectorXi &descriptor_indices, int nos, int N,
-                int lmax, const Eigen::VectorXd &wigner3j_coeffs) {
+// Shared by the real and complex single bond representations.
+template <typename Scalar>
+static void compute_B3_terms(
+    Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
+    Eigen::VectorXd &B3_norms, Eigen::VectorXd &B3_force_dots,
+    const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>
+        &single_bond_vals,
+    const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>
+        &single_bond_force_dervs,
+    const Eigen::VectorXi &unique_neighbor_count,
+    const Eigen::VectorXi &cumulative_neighbor_count, int nos, int N,
+    int lmax, const Wigner3jTerms &wigner3j_terms) {
 
   int n_atoms = single_bond_vals.rows();
   int n_neighbors = cumulative_neighbor_count(n_atoms);
   int n_radial = nos * N;
   int n_harmonics = (lmax + 1) * (lmax + 1);
   int n_bond = n_radial * n_harmonics;
-
-  int n_ls;
-  if (lmax == 0)
-    n_ls = 1;
-  else if (lmax == 1)
-    n_ls = 5;
-  else if (lmax == 2)
-    n_ls = 15;
-  else if (lmax == 3)
-    n_ls = 34;
-  else if (lmax == 4)
-    n_ls = 65;
+  int n_ls = wigner3j_terms.n_triples;
 
   int n_d = (n_radial * (n_radial + 1) * (n_radial + 2) / 6) * n_ls;
 
@@ -170,73 +164,85 @@ void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
   for (int atom = 0; atom < n_atoms; atom++) {
     int n_atom_neighbors = unique_neighbor_count(atom);
     int force_start = cumulative_neighbor_count(atom) * 3;
-    int n1, n2, n3, l1, l2, l3, m1, m2, m3, n1_l, n2_l, n3_l;
+    int n_rows = n_atom_neighbors * 3;
+
+    // Contiguous copy of the atom's single bond values.
+    Eigen::Matrix<Scalar, Eigen::Dynamic, 1> bond_vals =
+        single_bond_vals.row(atom).transpose();
+    auto bond_dervs =
+        single_bond_force_dervs.block(force_start, 0, n_rows, n_bond);
+
     int counter = 0;
     for (int n1 = 0; n1 < n_radial; n1++) {
       for (int n2 = n1; n2 < n_radial; n2++) {
         for (int n3 = n2; n3 < n_radial; n3++) {
-          for (int l1 = 0; l1 < (lmax + 1); l1++) {
-            int ind_1 = pow(lmax + 1, 4) * l1 * l1;
-            for (int l2 = 0; l2 < (lmax + 1); l2++) {
-              int ind_2 = ind_1 + pow(lmax + 1, 2) * l2 * l2 * (2 * l1 + 1);
-              for (int l3 = 0; l3 < (lmax + 1); l3++) {
-                if ((abs(l1 - l2) > l3) || (l3 > l1 + l2))
-                  continue;
-                int ind_3 = ind_2 + l3 * l3 * (2 * l2 + 1) * (2 * l1 + 1);
-                for (int m1 = 0; m1 < (2 * l1 + 1); m1++) {
-                  n1_l = n1 * n_harmonics + (l1 * l1 + m1);
-                  int ind_4 = ind_3 + m1 * (2 * l3 + 1) * (2 * l2 + 1);
-                  for (int m2 = 0; m2 < (2 * l2 + 1); m2++) {
-                    n2_l = n2 * n_harmonics + (l2 * l2 + m2);
-                    int ind_5 = ind_4 + m2 * (2 * l3 + 1);
-                    for (int m3 = 0; m3 < (2 * l3 + 1); m3++) {
-                      if (m1 + m2 + m3 - l1 - l2 - l3 != 0)
-                        continue;
-                      n3_l = n3 * n_harmonics + (l3 * l3 + m3);
-
-                      int m_index = ind_5 + m3;
-
-                      B3_vals(atom, counter) +=
-                          real(single_bond_vals(atom, n1_l) *
-                               single_bond_vals(atom, n2_l) *
-                               single_bond_vals(atom, n3_l) *
-                               wigner3j_coeffs(m_index));
-
-                      // Store force derivatives.
-                      for (int n = 0; n < n_atom_neighbors; n++) {
-                        for (int comp = 0; comp < 3; comp++) {
-                          int ind = force_start + n * 3 + comp;
-                          B3_force_dervs(ind, counter) +=
-                              real(wigner3j_coeffs(m_index) *
-                                   (single_bond_force_dervs(ind, n1_l) *
-                                        single_bond_vals(atom, n2_l) *
-                                        single_bond_vals(atom, n3_l) +
-                                    single_bond_vals(atom, n1_l) *
-                                        single_bond_force_dervs(ind, n2_l) *
-                                        single_bond_vals(atom, n3_l) +
-                                    single_bond_vals(atom, n1_l) *
-                                        single_bond_vals(atom, n2_l) *
-                                        single_bond_force_dervs(ind, n3_l)));
-                        }
-                      }
-                    }
-                  }
-                }
-                counter++;
-              }
+          for (int t = 0; t < n_ls; t++) {
+            auto force_col = B3_force_dervs.col(counter).segment(force_start,
+                                                                 n_rows);
+            double val = 0;
+            for (int k = wigner3j_terms.triple_start[t];
+                 k < wigner3j_terms.triple_start[t + 1]; k++) {
+              int n1_l = n1 * n_harmonics + wigner3j_terms.lm1[k];
+              int n2_l = n2 * n_harmonics + wigner3j_terms.lm2[k];
+              int n3_l = n3 * n_harmonics + wigner3j_terms.lm3[k];
+              double coeff = wigner3j_terms.coeffs[k];
+
+              Scalar v1 = bond_vals(n1_l);
+              Scalar v2 = bond_vals(n2_l);
+              Scalar v3 = bond_vals(n3_l);
+              val += std::real(v1 * v2 * v3 * coeff);
+
+              // Product rule, vectorized over neighbor components.
+              Scalar w1 = coeff * v2 * v3;
+              Scalar w2 = coeff * v1 * v3;
+              Scalar w3 = coeff * v1 * v2;
+              force_col += (bond_dervs.col(n1_l) * w1 +
+                            bond_dervs.col(n2_l) * w2 +
+                            bond_dervs.col(n3_l) * w3)
+                               .real();
             }
+            B3_vals(atom, counter) = val;
+            counter++;
           }
         }
       }
     }
     // Compute descriptor norm and force dot products.
     B3_norms(atom) = sqrt(B3_vals.row(atom).dot(B3_vals.row(atom)));
-    B3_force_dots.segment(force_start, n_atom_neighbors * 3) =
-        B3_force_dervs.block(force_start, 0, n_atom_neighbors * 3, n_d) *
+    B3_force_dots.segment(force_start, n_rows) =
+        B3_force_dervs.block(force_start, 0, n_rows, n_d) *
         B3_vals.row(atom).transpose();
   }
 }
 
+void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
+                Eigen::VectorXd &B3_norms, Eigen::VectorXd &B3_force_dots,
+                const Eigen::MatrixXd &single_bond_vals,
+                const Eigen::MatrixXd &single_bond_force_dervs,
+                const Eigen::VectorXi &unique_neighbor_count,
+                const Eigen::VectorXi &cumulative_neighbor_count,
+                const Eigen::VectorXi &descriptor_indices, int nos, int N,
+                int lmax, const Wigner3jTerms &wigner3j_terms) {
+  compute_B3_terms<double>(B3_vals, B3_force_dervs, B3_norms, B3_force_dots,
+                           single_bond_vals, single_bond_force_dervs,
+                           unique_neighbor_count, cumulative_neighbor_count,
+                           nos, N, lmax, wigner3j_terms);
+}
+
+void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
+                Eigen::VectorXd &B3_norms, Eigen::VectorXd &B3_force_dots,
+                const Eigen::MatrixXcd &single_bond_vals,
+                const Eigen::MatrixXcd &single_bond_force_dervs,
+                const Eigen::VectorXi &unique_neighbor_count,
+                const Eigen::VectorXi &cumulative_neighbor_count,
+                const Eigen::VectorXi &descriptor_indices, int nos, int N,
+                int lmax, const Wigner3jTerms &wigner3j_terms) {
+  compute_B3_terms<std::complex<double>>(
+      B3_vals, B3_force_dervs, B3_norms, B3_force_dots, single_bond_vals,
+      single_bond_force_dervs, unique_neighbor_count,
+      cumulative_neighbor_count, nos, N, lmax, wigner3j_terms);
+}
+
 void complex_single_bond(
     Eigen::MatrixXcd &single_bond_vals, Eigen::MatrixXcd &force_dervs,
     Eigen::MatrixXd &neighbor_coordinates, Eigen::VectorXi &neighbor_count,
@@ -2,6 +2,8 @@
 #define B3_H
 
 #include "descriptor.h"
+#include "wigner3j.h"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,7 +20,7 @@ public:
   std::string radial_basis, cutoff_function;
   std::vector<double> radial_hyps, cutoff_hyps;
   std::vector<int> descriptor_settings;
-  Eigen::VectorXd wigner3j_coeffs;
+  std::shared_ptr<const Wigner3jTerms> wigner3j_terms;
 
   std::string descriptor_name = "B3";
 
@@ -34,6 +36,23 @@ public:
   nlohmann::json return_json();
 };
 
+/**
+ * Compute B3 from real single bond values (see compute_single_bond), using
+ * the real coupling coefficients of get_wigner3j_terms(lmax, true).
+ */
+void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
+                Eigen::VectorXd &B3_norms, Eigen::VectorXd &B3_force_dots,
+                const Eigen::MatrixXd &single_bond_vals,
+                const Eigen::MatrixXd &single_bond_force_dervs,
+                const Eigen::VectorXi &unique_neighbor_count,
+                const Eigen::VectorXi &cumulative_neighbor_count,
+                const Eigen::VectorXi &descriptor_indices, int nos, int N,
+                int lmax, const Wigner3jTerms &wigner3j_terms);
+
+/**
+ * Complex version, with the coefficients of get_wigner3j_terms(lmax). Gives
+ * the same invariants as the real version.
+ */
 void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
                 Eigen::VectorXd &B3_norms, Eigen::VectorXd &B3_force_dots,
                 const Eigen::MatrixXcd &single_bond_vals,
@@ -41,7 +60,7 @@ void compute_B3(Eigen::MatrixXd &B3_vals, Eigen::MatrixXd &B3_force_dervs,
                 const Eigen::VectorXi &unique_neighbor_count,
                 const Eigen::VectorXi &cumulative_neighbor_count,
                 const Eigen::VectorXi &descriptor_indices, int nos, int N,
-                int lmax, const Eigen::VectorXd &wigner3j_coeffs);
+                int lmax, const Wigner3jTerms &wigner3j_terms);
 
 void complex_single_bond(
     Eigen::MatrixXcd &single_bond_vals, Eigen::MatrixXcd &force_dervs,
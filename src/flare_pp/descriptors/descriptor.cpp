@@ -3,8 +3,11 @@
 #include "radial.h"
 #include "structure.h"
 #include "b2.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 Descriptor::Descriptor() {}
 
@@ -40,6 +43,187 @@ void from_json(const nlohmann::json& j, std::vector<Descriptor*> & p){
 
 DescriptorValues::DescriptorValues() {}
 
+void to_json(nlohmann::json &j, const DescriptorValues &desc) {
+  j["n_descriptors"] = desc.n_descriptors;
+  j["n_types"] = desc.n_types;
+  j["n_atoms"] = desc.n_atoms;
+  j["volume"] = desc.volume;
+  j["descriptors"] = desc.descriptors;
+  j["descriptor_force_dervs"] = desc.descriptor_force_dervs;
+  j["neighbor_coordinates"] = desc.neighbor_coordinates;
+  j["descriptor_norms"] = desc.descriptor_norms;
+  j["descriptor_force_dots"] = desc.descriptor_force_dots;
+  j["cutoff_values"] = desc.cutoff_values;
+  j["cutoff_dervs"] = desc.cutoff_dervs;
+  j["neighbor_counts"] = desc.neighbor_counts;
+  j["cumulative_neighbor_counts"] = desc.cumulative_neighbor_counts;
+  j["atom_indices"] = desc.atom_indices;
+  j["neighbor_indices"] = desc.neighbor_indices;
+  j["n_clusters"] = desc.n_clusters;
+  j["n_clusters_by_type"] = desc.n_clusters_by_type;
+  j["cumulative_type_count"] = desc.cumulative_type_count;
+  j["n_neighbors_by_type"] = desc.n_neighbors_by_type;
+  j["force_dervs_basis"] = desc.force_dervs_basis;
+}
+
+void from_json(const nlohmann::json &j, DescriptorValues &desc) {
+  j.at("n_descriptors").get_to(desc.n_descriptors);
+  j.at("n_types").get_to(desc.n_types);
+  j.at("n_atoms").get_to(desc.n_atoms);
+  j.at("volume").get_to(desc.volume);
+  j.at("descriptors").get_to(desc.descriptors);
+  j.at("descriptor_force_dervs").get_to(desc.descriptor_force_dervs);
+  j.at("neighbor_coordinates").get_to(desc.neighbor_coordinates);
+  j.at("descriptor_norms").get_to(desc.descriptor_norms);
+  j.at("descriptor_force_dots").get_to(desc.descriptor_force_dots);
+  j.at("cutoff_values").get_to(desc.cutoff_values);
+  j.at("cutoff_dervs").get_to(desc.cutoff_dervs);
+  j.at("neighbor_counts").get_to(desc.neighbor_counts);
+  j.at("cumulative_neighbor_counts").get_to(desc.cumulative_neighbor_counts);
+  j.at("atom_indices").get_to(desc.atom_indices);
+  j.at("neighbor_indices").get_to(desc.neighbor_indices);
+  j.at("n_clusters").get_to(desc.n_clusters);
+  j.at("n_clusters_by_type").get_to(desc.n_clusters_by_type);
+  j.at("cumulative_type_count").get_to(desc.cumulative_type_count);
+  j.at("n_neighbors_by_type").get_to(desc.n_neighbors_by_type);
+  desc.force_dervs_basis.clear();
+  if (j.contains("force_dervs_basis"))
+    j.at("force_dervs_basis").get_to(desc.force_dervs_basis);
+}
+
+void DescriptorValues ::compress_force_dervs(
+    const std::vector<const ClusterDescriptor *> &envs) {
+  if (compressed())
+    return;
+
+  for (int s = 0; s < n_types; s++) {
+    // Stack the descriptors of the structure and the environments.
+    int n_struc = descriptors[s].rows();
+    int n_vecs = n_struc;
+    for (int k = 0; k < envs.size(); k++) {
+      if (s < envs[k]->descriptors.size())
+        n_vecs += envs[k]->descriptors[s].rows();
+    }
+    Eigen::MatrixXd span_vecs(n_descriptors, n_vecs);
+    span_vecs.leftCols(n_struc) = descriptors[s].transpose();
+    int count = n_struc;
+    for (int k = 0; k < envs.size(); k++) {
+      if (s >= envs[k]->descriptors.size())
+        continue;
+      int n_envs = envs[k]->descriptors[s].rows();
+      span_vecs.middleCols(count, n_envs) = envs[k]->descriptors[s].transpose();
+      count += n_envs;
+    }
+
+    if (span_vecs.cols() == 0) {
+      descriptor_force_dervs[s].resize(descriptor_force_dervs[s].rows(), 0);
+      force_dervs_basis.push_back(Eigen::MatrixXd::Zero(n_descriptors, 0));
+      continue;
+    }
+
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(span_vecs);
+    int rank = qr.rank();
+
+    // Keep the full derivatives if the span is not smaller.
+    if (rank >= n_descriptors) {
+      force_dervs_basis.push_back(Eigen::MatrixXd());
+      continue;
+    }
+
+    Eigen::MatrixXd basis = qr.householderQ() *
+                            Eigen::MatrixXd::Identity(n_descriptors, rank);
+    descriptor_force_dervs[s] = descriptor_force_dervs[s] * basis;
+    force_dervs_basis.push_back(basis);
+  }
+}
+
+bool DescriptorValues ::force_dervs_span_contains(
+    const ClusterDescriptor &envs) const {
+  if (!compressed())
+    return true;
+
+  double span_thresh = 1e-10;
+  for (int s = 0; s < n_types && s < envs.descriptors.size(); s++) {
+    // Types without derivatives, or stored in full, give exact kernels.
+    const Eigen::MatrixXd &basis = force_dervs_basis[s];
+    if (descriptor_force_dervs[s].rows() == 0 || basis.rows() == 0)
+      continue;
+
+    const Eigen::MatrixXd &env_descriptors = envs.descriptors[s];
+    for (int i = 0; i < env_descriptors.rows(); i++) {
+      Eigen::VectorXd d = env_descriptors.row(i).transpose();
+      double residual = (d - basis * (basis.transpose() * d)).norm();
+      if (residual > span_thresh * d.norm())
+        return false;
+    }
+  }
+  return true;
+}
+
+DescriptorValues DescriptorValues ::expand_force_dervs() const {
+  DescriptorValues expanded = *this;
+  if (!compressed())
+    return expanded;
+
+  for (int s = 0; s < n_types; s++) {
+    if (force_dervs_basis[s].rows() == 0)
+      continue;
+    expanded.descriptor_force_dervs[s] =
+        descriptor_force_dervs[s] * force_dervs_basis[s].transpose();
+  }
+  expanded.force_dervs_basis.clear();
+  return expanded;
+}
+
+bool DescriptorValues ::compressed() const {
+  return force_dervs_basis.size() != 0;
+}
+
+static std::vector<int> build_atom_clusters(const DescriptorValues &desc) {
+  std::vector<int> atom_clusters(desc.n_atoms, -1);
+  for (int s = 0; s < desc.n_types; s++) {
+    for (int i = 0; i < desc.n_clusters_by_type[s]; i++) {
+      atom_clusters[desc.atom_indices[s](i)] =
+          desc.cumulative_type_count[s] + i;
+    }
+  }
+  return atom_clusters;
+}
+
+void DescriptorValues ::index_atoms() {
+  atom_clusters = build_atom_clusters(*this);
+}
+
+std::vector<int>
+DescriptorValues ::clusters_of_atoms(const std::vector<int> &atoms) const {
+  // Descriptors loaded from a file are not indexed.
+  std::vector<int> local_index;
+  const std::vector<int> *index = &atom_clusters;
+  if (atom_clusters.size() != n_atoms) {
+    local_index = build_atom_clusters(*this);
+    index = &local_index;
+  }
+
+  std::vector<int> clusters;
+  for (int i = 0; i < atoms.size(); i++) {
+    int atom = atoms[i];
+    if (atom >= 0 && atom < n_atoms && (*index)[atom] != -1)
+      clusters.push_back((*index)[atom]);
+  }
+  return clusters;
+}
+
+int DescriptorValues ::cluster_type(int cluster) const {
+  return std::upper_bound(cumulative_type_count.begin(),
+                          cumulative_type_count.begin() + n_types, cluster) -
+         cumulative_type_count.begin() - 1;
+}
+
+int DescriptorValues ::cluster_atom(int cluster) const {
+  int type = cluster_type(cluster);
+  return atom_indices[type](cluster - cumulative_type_count[type]);
+}
+
 ClusterDescriptor::ClusterDescriptor() {}
 
 ClusterDescriptor::ClusterDescriptor(const DescriptorValues &structure) {
@@ -60,7 +244,7 @@ ClusterDescriptor::ClusterDescriptor(const DescriptorValues &structure,
 }
 
 void ClusterDescriptor ::initialize_cluster(int n_types, int n_descriptors) {
-  if (n_clusters != 0)
+  if (descriptors.size() != 0)
     return;
 
   this->n_types = n_types;
@@ -83,18 +267,9 @@ void ClusterDescriptor ::add_clusters(const DescriptorValues &structure,
   // Determine the type of each cluster.
   std::vector<std::vector<int>> clusters_by_type(structure.n_types);
   for (int i = 0; i < clusters.size(); i++) {
-    int cluster_val = clusters[i];
-    int type, val;
-    for (int j = 0; j < structure.n_types; j++) {
-      int ccount = structure.cumulative_type_count[j];
-      int ccount_p1 = structure.cumulative_type_count[j + 1];
-      if ((cluster_val >= ccount) && (cluster_val < ccount_p1)) {
-        type = j;
-        val = cluster_val - ccount;
-        break;
-      }
-    }
-    clusters_by_type[type].push_back(val);
+    int type = structure.cluster_type(clusters[i]);
+    clusters_by_type[type].push_back(clusters[i] -
+                                     structure.cumulative_type_count[type]);
   }
 
   // Add clusters.
@@ -139,6 +314,39 @@ void ClusterDescriptor ::add_clusters_by_type(
   }
 }
 
+void ClusterDescriptor ::remove_clusters(const std::vector<int> &clusters) {
+  std::vector<bool> removed(n_clusters, false);
+  for (int i = 0; i < clusters.size(); i++) {
+    if (clusters[i] < 0 || clusters[i] >= n_clusters)
+      throw std::invalid_argument("Removed cluster " +
+                                  std::to_string(clusters[i]) +
+                                  " is out of range.");
+    removed[clusters[i]] = true;
+  }
+
+  int count = 0;
+  for (int s = 0; s < n_types; s++) {
+    std::vector<int> kept;
+    for (int i = 0; i < n_clusters_by_type[s]; i++) {
+      if (!removed[cumulative_type_count[s] + i])
+        kept.push_back(i);
+    }
+    // Kept clusters move up, so the rows are compacted in place.
+    for (int i = 0; i < kept.size(); i++) {
+      descriptors[s].row(i) = descriptors[s].row(kept[i]);
+      descriptor_norms[s](i) = descriptor_norms[s](kept[i]);
+      cutoff_values[s](i) = cutoff_values[s](kept[i]);
+    }
+    descriptors[s].conservativeResize(kept.size(), Eigen::NoChange);
+    descriptor_norms[s].conservativeResize(kept.size());
+    cutoff_values[s].conservativeResize(kept.size());
+    n_clusters_by_type[s] = kept.size();
+    cumulative_type_count[s] = count;
+    count += kept.size();
+  }
+  n_clusters = count;
+}
+
 void ClusterDescriptor ::add_all_clusters(const DescriptorValues &structure) {
 
   initialize_cluster(structure.n_types, structure.n_descriptors);
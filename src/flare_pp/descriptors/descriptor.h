@@ -8,6 +8,7 @@
 
 class Structure;
 class DescriptorValues;
+class ClusterDescriptor;
 
 class Descriptor {
 public:
@@ -47,13 +48,45 @@ public:
   std::vector<int> n_clusters_by_type, cumulative_type_count,
       n_neighbors_by_type;
 
-  NLOHMANN_DEFINE_TYPE_INTRUSIVE(DescriptorValues,
-    n_descriptors, n_types, n_atoms, volume, descriptors,
-    descriptor_force_dervs, neighbor_coordinates, descriptor_norms,
-    descriptor_force_dots, cutoff_values, cutoff_dervs, neighbor_counts,
-    cumulative_neighbor_counts, atom_indices, neighbor_indices,
-    n_clusters, n_clusters_by_type, cumulative_type_count,
-    n_neighbors_by_type)
+  // Orthonormal basis (n_descriptors x rank) of each type used to compress
+  // the force derivatives. Empty if the derivatives are stored in full. An
+  // empty matrix for a single type means that type was not compressed.
+  std::vector<Eigen::MatrixXd> force_dervs_basis;
+
+  // Project the force derivatives onto the span of this structure's
+  // descriptors and the descriptors of the given sets of environments. Dot
+  // products of the derivatives with any vector in that span are unchanged.
+  void compress_force_dervs(const std::vector<const ClusterDescriptor *> &envs);
+
+  // True if the derivatives are stored in full, or if the descriptors of
+  // all the given environments lie in the span they were compressed against,
+  // so that kernels with them are exact.
+  bool force_dervs_span_contains(const ClusterDescriptor &envs) const;
+
+  // Return a copy with the force derivatives restored to full size.
+  DescriptorValues expand_force_dervs() const;
+  bool compressed() const;
+
+  // Inverse of atom_indices: atom_clusters[a] is the index of the cluster
+  // centered on atom a in the type-sorted list of all clusters, or -1 if
+  // atom a has no cluster. Built by index_atoms, which Structure calls after
+  // computing the descriptors.
+  std::vector<int> atom_clusters;
+  void index_atoms();
+
+  // Clusters centered on the given atoms, in the order of the atoms. Atoms
+  // without a cluster are skipped.
+  std::vector<int> clusters_of_atoms(const std::vector<int> &atoms) const;
+
+  // Type and central atom of a cluster in the type-sorted list of all
+  // clusters.
+  int cluster_type(int cluster) const;
+  int cluster_atom(int cluster) const;
+
+  // force_dervs_basis is optional when reading, so that structures saved
+  // before compression was added still load.
+  friend void to_json(nlohmann::json &j, const DescriptorValues &desc);
+  friend void from_json(const nlohmann::json &j, DescriptorValues &desc);
 };
 
 // ClusterDescriptor holds the descriptor values for a collection of clusters
@@ -84,6 +117,10 @@ public:
                     const std::vector<int> &clusters);
   void add_all_clusters(const DescriptorValues &structure);
 
+  // Remove clusters, given by their index in the type-sorted list of all
+  // clusters. The remaining clusters keep their order.
+  void remove_clusters(const std::vector<int> &clusters);
+
   NLOHMANN_DEFINE_TYPE_INTRUSIVE(ClusterDescriptor,
     descriptors, descriptor_norms, cutoff_values, n_clusters_by_type,
     cumulative_type_count, n_descriptors, n_types, n_clusters)
@@ -1,10 +1,33 @@
 #ifndef WIGNER3J
 #define WIGNER3J
 #include <Eigen/Dense>
+#include <memory>
+#include <vector>
 
-// Wigner 3j coefficients generated for l = 0, 1, 2, 3 using
-// sympy.physics.wigner.wigner_3j
+// Nonzero Wigner 3j coefficients of the B3 descriptor, grouped by allowed
+// (l1, l2, l3) triple. The terms of triple t are stored in the range
+// [triple_start[t], triple_start[t + 1]), and lm1, lm2 and lm3 give the
+// index l * l + m of the spherical harmonics entering each product.
+struct Wigner3jTerms {
+  int n_triples = 0;
+  std::vector<int> triple_start, lm1, lm2, lm3;
+  std::vector<double> coeffs;
+};
 
+// Wigner 3j symbol (l1 l2 l3; m1 m2 m3) from the Racah formula.
+double wigner3j(int l1, int l2, int l3, int m1, int m2, int m3);
+
+// Sparse B3 coefficients for a given lmax. If real_harmonics is true, the
+// coefficients couple the real spherical harmonics of get_Y instead of the
+// complex harmonics of get_complex_Y, and give the same invariants. Tables
+// are generated on first use and shared by all descriptors with the same
+// settings.
+std::shared_ptr<const Wigner3jTerms>
+get_wigner3j_terms(int lmax, bool real_harmonics = false);
+Wigner3jTerms compute_wigner3j_terms(int lmax, bool real_harmonics = false);
+
+// Dense coefficients indexed by (l1, l2, l3, m1, m2, m3), with each
+// (l1, l2, l3) block stored contiguously in row-major order.
 Eigen::VectorXd compute_coeffs(int lmax);
 
 #endif
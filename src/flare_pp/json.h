@@ -2,18 +2,35 @@
 #define JSON_H
 
 #include <nlohmann/json.hpp>
+#include "binary.h"
 
 // Cf. the Simox library on Gitlab.
+// While a binary container is being written (see binary.h), the Eigen
+// serializers store references to raw arrays instead of elements. When
+// reading, references resolved by an ArrayReader are copied from the
+// mapped file.
 // TODO: Use templating to reduce redundancy.
 namespace nlohmann {
   template <> struct adl_serializer<Eigen::VectorXi> {
     static void to_json(json &j, const Eigen::VectorXi &vector) {
+      if (flare_binary::active_writer()) {
+        j = flare_binary::active_writer()->add(
+            vector.data(), flare_binary::int32, vector.size(), 1);
+        return;
+      }
       for (int row = 0; row < vector.size(); row++) {
         j.push_back(vector(row));
       }
     }
 
     static void from_json(const json &j, Eigen::VectorXi &vector) {
+      if (flare_binary::is_reference(j)) {
+        flare_binary::ArrayView view =
+            flare_binary::referenced_array(j, flare_binary::int32);
+        vector = Eigen::Map<const Eigen::VectorXi>(
+            static_cast<const int *>(view.data), view.rows * view.cols);
+        return;
+      }
       int n_rows = j.size();
       vector = Eigen::VectorXi::Zero(n_rows);
 
@@ -26,12 +43,24 @@ namespace nlohmann {
 
   template <> struct adl_serializer<Eigen::VectorXd> {
     static void to_json(json &j, const Eigen::VectorXd &vector) {
+      if (flare_binary::active_writer()) {
+        j = flare_binary::active_writer()->add(
+            vector.data(), flare_binary::float64, vector.size(), 1);
+        return;
+      }
       for (int row = 0; row < vector.size(); row++) {
         j.push_back(vector(row));
       }
     }
 
     static void from_json(const json &j, Eigen::VectorXd &vector) {
+      if (flare_binary::is_reference(j)) {
+        flare_binary::ArrayView view =
+            flare_binary::referenced_array(j, flare_binary::float64);
+        vector = Eigen::Map<const Eigen::VectorXd>(
+            static_cast<const double *>(view.data), view.rows * view.cols);
+        return;
+      }
       int n_rows = j.size();
       vector = Eigen::VectorXd::Zero(n_rows);
 
@@ -44,6 +73,11 @@ namespace nlohmann {
 
   template <> struct adl_serializer<Eigen::MatrixXd> {
     static void to_json(json &j, const Eigen::MatrixXd &matrix) {
+      if (flare_binary::active_writer()) {
+        j = flare_binary::active_writer()->add(
+            matrix.data(), flare_binary::float64, matrix.rows(), matrix.cols());
+        return;
+      }
       for (int row = 0; row < matrix.rows(); row++) {
         nlohmann::json column = nlohmann::json::array();
 
@@ -56,6 +90,13 @@ namespace nlohmann {
     }
 
     static void from_json(const json &j, Eigen::MatrixXd &matrix) {
+      if (flare_binary::is_reference(j)) {
+        flare_binary::ArrayView view =
+            flare_binary::referenced_array(j, flare_binary::float64);
+        matrix = Eigen::Map<const Eigen::MatrixXd>(
+            static_cast<const double *>(view.data), view.rows, view.cols);
+        return;
+      }
       int n_rows = j.size();
       int n_cols;
       if (n_rows > 0)
@@ -73,6 +114,20 @@ namespace nlohmann {
       }
     }
   };
+
+  // Read-only views, such as the solution matrices of a mapped model (see
+  // SparseGP::from_binary). Written like the matrices they view.
+  template <> struct adl_serializer<Eigen::Map<const Eigen::MatrixXd>> {
+    static void to_json(json &j,
+                        const Eigen::Map<const Eigen::MatrixXd> &matrix) {
+      if (flare_binary::active_writer()) {
+        j = flare_binary::active_writer()->add(
+            matrix.data(), flare_binary::float64, matrix.rows(), matrix.cols());
+        return;
+      }
+      j = Eigen::MatrixXd(matrix);
+    }
+  };
 }
 
 #endif
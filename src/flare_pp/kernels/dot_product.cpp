@@ -1,5 +1,6 @@
 #include "dot_product.h"
 #include "descriptor.h"
+#include "normalized_dot_product.h"
 #include "sparse_gp.h"
 #include "structure.h"
 #undef NDEBUG
@@ -87,6 +88,33 @@ Eigen::MatrixXd DotProduct ::envs_envs(const ClusterDescriptor &envs1,
   return kern_mat;
 }
 
+Eigen::VectorXd DotProduct ::self_kernel_envs(const ClusterDescriptor &envs,
+                                              const Eigen::VectorXd &hyps) {
+
+  double sig_sq = hyps(0) * hyps(0);
+  double empty_thresh = 1e-8;
+
+  Eigen::VectorXd kernel_vector = Eigen::VectorXd::Zero(envs.n_clusters);
+  for (int s = 0; s < envs.n_types; s++) {
+    int n_clusters = envs.n_clusters_by_type[s];
+    int c_clusters = envs.cumulative_type_count[s];
+
+#pragma omp parallel for
+    for (int i = 0; i < n_clusters; i++) {
+      double norm_i = envs.descriptor_norms[s](i);
+
+      // Continue if environment i has no neighbors.
+      if (norm_i < empty_thresh)
+        continue;
+
+      double norm_dot = envs.descriptors[s].row(i).squaredNorm();
+      kernel_vector(c_clusters + i) = sig_sq * pow(norm_dot, power);
+    }
+  }
+
+  return kernel_vector;
+}
+
 std::vector<Eigen::MatrixXd>
 DotProduct ::envs_envs_grad(const ClusterDescriptor &envs1,
                                       const ClusterDescriptor &envs2,
@@ -100,6 +128,8 @@ DotProduct ::envs_envs_grad(const ClusterDescriptor &envs1,
   return grad_mats;
 }
 
+bool DotProduct ::type_diagonal() { return true; }
+
 std::vector<Eigen::MatrixXd>
 DotProduct ::envs_struc_grad(const ClusterDescriptor &envs,
                                        const DescriptorValues &struc,
@@ -228,7 +258,6 @@ DotProduct ::struc_struc(const DescriptorValues &struc1,
   // Check types.
   int n_types_1 = struc1.n_types;
   int n_types_2 = struc2.n_types;
-  bool type_check = (n_types_1 == n_types_2);
   assert(n_types_1 == n_types_2);
 
   // Check descriptor size.
@@ -236,211 +265,9 @@ DotProduct ::struc_struc(const DescriptorValues &struc1,
   int n_descriptors_2 = struc2.n_descriptors;
   assert(n_descriptors_1 == n_descriptors_2);
 
-  double vol_inv_1 = 1 / struc1.volume;
-  double vol_inv_2 = 1 / struc2.volume;
-
-  double empty_thresh = 1e-8;
-  std::vector<int> stress_inds{0, 3, 5};
-
   for (int s = 0; s < n_types_1; s++) {
-    // Compute dot products.
-    Eigen::MatrixXd dot_vals =
-        struc1.descriptors[s] * struc2.descriptors[s].transpose();
-    Eigen::MatrixXd force_dot_1 =
-        struc1.descriptor_force_dervs[s] * struc2.descriptors[s].transpose();
-    Eigen::MatrixXd force_dot_2 =
-        struc2.descriptor_force_dervs[s] * struc1.descriptors[s].transpose();
-    Eigen::MatrixXd force_force = struc1.descriptor_force_dervs[s] *
-                                  struc2.descriptor_force_dervs[s].transpose();
-
-    Eigen::VectorXd struc_force_dot_1 = struc1.descriptor_force_dots[s];
-    Eigen::VectorXd struc_force_dot_2 = struc2.descriptor_force_dots[s];
-
-    // Compute kernels.
-    int n_struc1 = struc1.n_clusters_by_type[s];
-    int n_struc2 = struc2.n_clusters_by_type[s];
-
-    // TODO: Parallelize.
-    for (int i = 0; i < n_struc1; i++) {
-      double norm_i = struc1.descriptor_norms[s](i);
-
-      // Continue if atom i has no neighbors.
-      if (norm_i < empty_thresh)
-        continue;
-
-      double norm_i2 = norm_i * norm_i;
-      double norm_i3 = norm_i2 * norm_i;
-
-      for (int j = 0; j < n_struc2; j++) {
-        double norm_j = struc2.descriptor_norms[s](j);
-
-        // Continue if atom j has no neighbors.
-        if (norm_j < empty_thresh)
-          continue;
-
-        double norm_j2 = norm_j * norm_j;
-        double norm_j3 = norm_j2 * norm_j;
-        double norm_ij = norm_i * norm_j;
-
-        // Energy/energy kernel.
-        double norm_dot = dot_vals(i, j) / norm_ij;
-        double c1 = (power - 1) * power * pow(norm_dot, power - 2);
-        if (abs(norm_dot) < empty_thresh && power < 2) {
-            throw std::invalid_argument( "Dot product of descriptors is 0, \
-                and the negative power function in force-force kernel diverges." );
-        }
-        double c2 = power * pow(norm_dot, power - 1);
-        kernel_matrix(0, 0) += sig_sq * pow(norm_dot, power);
-
-        int n_neigh_1 = struc1.neighbor_counts[s](i);
-        int c_neigh_1 = struc1.cumulative_neighbor_counts[s](i);
-        int c_ind_1 = struc1.atom_indices[s](i);
-
-        int n_neigh_2 = struc2.neighbor_counts[s](j);
-        int c_neigh_2 = struc2.cumulative_neighbor_counts[s](j);
-        int c_ind_2 = struc2.atom_indices[s](j);
-
-        // Energy/force and energy/stress kernels.
-        for (int k = 0; k < n_neigh_2; k++) {
-          int ind = c_neigh_2 + k;
-          int neighbor_index = struc2.neighbor_indices[s](ind);
-          int stress_counter = 0;
-
-          for (int comp = 0; comp < 3; comp++) {
-            int force_index = 3 * ind + comp;
-            double f1 = force_dot_2(force_index, i) / norm_ij;
-            double f2 = dot_vals(i, j) * struc_force_dot_2(force_index) /
-                        (norm_i * norm_j3);
-            double f3 = f1 - f2;
-            double force_kern_val = sig_sq * c2 * f3;
-
-            // Energy/force.
-            kernel_matrix(0, 1 + 3 * neighbor_index + comp) -= force_kern_val;
-            kernel_matrix(0, 1 + 3 * c_ind_2 + comp) += force_kern_val;
-
-            // Energy/stress.
-            for (int comp2 = comp; comp2 < 3; comp2++) {
-              double coord = struc2.neighbor_coordinates[s](ind, comp2);
-              kernel_matrix(0, 1 + 3 * struc2.n_atoms + stress_counter) -=
-                  force_kern_val * coord * vol_inv_2;
-              stress_counter++;
-            }
-          }
-        }
-
-        // Force/energy and stress/energy kernels.
-        for (int k = 0; k < n_neigh_1; k++) {
-          int ind = c_neigh_1 + k;
-          int neighbor_index = struc1.neighbor_indices[s](ind);
-          int stress_counter = 0;
-
-          for (int comp = 0; comp < 3; comp++) {
-            int force_index = 3 * ind + comp;
-            double f1 = force_dot_1(force_index, j) / norm_ij;
-            double f2 = dot_vals(i, j) * struc_force_dot_1(force_index) /
-                        (norm_j * norm_i3);
-            double f3 = f1 - f2;
-            double force_kern_val = sig_sq * c2 * f3;
-
-            // Force/energy.
-            kernel_matrix(1 + 3 * neighbor_index + comp, 0) -= force_kern_val;
-            kernel_matrix(1 + 3 * c_ind_1 + comp, 0) += force_kern_val;
-
-            // Stress/energy.
-            for (int comp2 = comp; comp2 < 3; comp2++) {
-              double coord = struc1.neighbor_coordinates[s](ind, comp2);
-              kernel_matrix(1 + 3 * struc1.n_atoms + stress_counter, 0) -=
-                  force_kern_val * coord * vol_inv_1;
-              stress_counter++;
-            }
-          }
-        }
-
-        // Force/force, force/stress, stress/force, and stress/stress kernels.
-        for (int k = 0; k < n_neigh_1; k++) {
-          int ind1 = c_neigh_1 + k;
-          int n_ind_1 = struc1.neighbor_indices[s](ind1);
-
-          for (int l = 0; l < n_neigh_2; l++) {
-            int ind2 = c_neigh_2 + l;
-            int n_ind_2 = struc2.neighbor_indices[s](ind2);
-
-            for (int m = 0; m < 3; m++) {
-              int f_ind_1 = 3 * ind1 + m;
-              for (int n = 0; n < 3; n++) {
-                int f_ind_2 = 3 * ind2 + n;
-                double v1 = force_dot_1(f_ind_1, j) / norm_ij -
-                            norm_dot * struc_force_dot_1(f_ind_1) / norm_i2;
-                double v2 = force_dot_2(f_ind_2, i) / norm_ij -
-                            norm_dot * struc_force_dot_2(f_ind_2) / norm_j2;
-                double v3 = force_force(f_ind_1, f_ind_2) / norm_ij;
-                double v4 = struc_force_dot_1(f_ind_1) *
-                            force_dot_2(f_ind_2, i) / (norm_i3 * norm_j);
-                double v5 = struc_force_dot_2(f_ind_2) *
-                            force_dot_1(f_ind_1, j) / (norm_i * norm_j3);
-                double v6 = struc_force_dot_1(f_ind_1) *
-                            struc_force_dot_2(f_ind_2) * norm_dot /
-                            (norm_i2 * norm_j2);
-
-                double kern_val =
-                    sig_sq * (c1 * v1 * v2 + c2 * (v3 - v4 - v5 + v6));
-
-                // Force/force.
-                kernel_matrix(1 + c_ind_1 * 3 + m, 1 + c_ind_2 * 3 + n) +=
-                    kern_val;
-                kernel_matrix(1 + c_ind_1 * 3 + m, 1 + n_ind_2 * 3 + n) -=
-                    kern_val;
-                kernel_matrix(1 + n_ind_1 * 3 + m, 1 + c_ind_2 * 3 + n) -=
-                    kern_val;
-                kernel_matrix(1 + n_ind_1 * 3 + m, 1 + n_ind_2 * 3 + n) +=
-                    kern_val;
-
-                // Stress/force.
-                int stress_ind_1 = stress_inds[m];
-                for (int p = m; p < 3; p++) {
-                  double coord = struc1.neighbor_coordinates[s](ind1, p);
-                  kernel_matrix(1 + 3 * struc1.n_atoms + stress_ind_1,
-                                1 + c_ind_2 * 3 + n) -=
-                      kern_val * coord * vol_inv_1;
-                  kernel_matrix(1 + 3 * struc1.n_atoms + stress_ind_1,
-                                1 + n_ind_2 * 3 + n) +=
-                      kern_val * coord * vol_inv_1;
-                  stress_ind_1++;
-                }
-
-                // Force/stress.
-                int stress_ind_2 = stress_inds[n];
-                for (int p = n; p < 3; p++) {
-                  double coord = struc2.neighbor_coordinates[s](ind2, p);
-                  kernel_matrix(1 + c_ind_1 * 3 + m,
-                                1 + 3 * struc2.n_atoms + stress_ind_2) -=
-                      kern_val * coord * vol_inv_2;
-                  kernel_matrix(1 + n_ind_1 * 3 + m,
-                                1 + 3 * struc2.n_atoms + stress_ind_2) +=
-                      kern_val * coord * vol_inv_2;
-                  stress_ind_2++;
-                }
-
-                // Stress/stress.
-                stress_ind_1 = stress_inds[m];
-                for (int p = m; p < 3; p++) {
-                  double coord1 = struc1.neighbor_coordinates[s](ind1, p);
-                  stress_ind_2 = stress_inds[n];
-                  for (int q = n; q < 3; q++) {
-                    double coord2 = struc2.neighbor_coordinates[s](ind2, q);
-                    kernel_matrix(1 + 3 * struc1.n_atoms + stress_ind_1,
-                                  1 + 3 * struc2.n_atoms + stress_ind_2) +=
-                        kern_val * coord1 * coord2 * vol_inv_1 * vol_inv_2;
-                    stress_ind_2++;
-                  }
-                  stress_ind_1++;
-                }
-              }
-            }
-          }
-        }
-      }
-    }
+    normalized_dot_struc_struc(kernel_matrix, struc1, s, struc2, s, sig_sq,
+                               power, true, max_block_entries);
   }
 
   return kernel_matrix;
@@ -789,6 +616,10 @@ Eigen::MatrixXd DotProduct ::compute_varmap_coefficients(
   //mapping_coeffs = Eigen::MatrixXd::Zero(n_species * n_species, p_size * p_size); // can be reduced by symmetry
   mapping_coeffs = Eigen::MatrixXd::Zero(n_species, p_size * p_size); // can be reduced by symmetry
 
+  // The inverse is read from the mapped file of prediction-only models.
+  Eigen::Map<const Eigen::MatrixXd> Kuu_inverse =
+      gp_model.solution_matrix("Kuu_inverse");
+
   // Get alpha index.
   
   int alpha_ind = 0;
@@ -826,7 +657,7 @@ Eigen::MatrixXd DotProduct ::compute_varmap_coefficients(
         if (pj_norm < empty_thresh)
           continue;
 
-        double Kuu_inv_ij = gp_model.Kuu_inverse(K_ind + i, K_ind + j);
+        double Kuu_inv_ij = Kuu_inverse(K_ind + i, K_ind + j);
         double Kuu_inv_ij_normed = Kuu_inv_ij; // / pi_norm / pj_norm;
 //        double Sigma_ij = gp_model.Sigma(K_ind + i, K_ind + j);
 //        double Sigma_ij_normed = Sigma_ij / pi_norm / pj_norm;
@@ -12,6 +12,9 @@ class DotProduct : public Kernel {
 public:
   double sigma, sig2, power;
 
+  /** Entry limit of the force/force blocks formed by struc_struc. */
+  long max_block_entries = 1 << 24;
+
   DotProduct();
 
   DotProduct(double sigma, double power);
@@ -20,10 +23,15 @@ public:
                             const ClusterDescriptor &envs2,
                             const Eigen::VectorXd &hyps);
 
+  Eigen::VectorXd self_kernel_envs(const ClusterDescriptor &envs,
+                                   const Eigen::VectorXd &hyps);
+
   std::vector<Eigen::MatrixXd> envs_envs_grad(const ClusterDescriptor &envs1,
                                               const ClusterDescriptor &envs2,
                                               const Eigen::VectorXd &hyps);
 
+  bool type_diagonal();
+
   Eigen::MatrixXd envs_struc(const ClusterDescriptor &envs,
                              const DescriptorValues &struc,
                              const Eigen::VectorXd &hyps);
@@ -21,6 +21,22 @@ std::vector<Eigen::MatrixXd> Kernel ::Kuu_grad(const ClusterDescriptor &envs,
   return Kuu_grad;
 }
 
+bool Kernel ::type_diagonal() { return false; }
+
+std::vector<Eigen::MatrixXd>
+Kernel ::envs_struc_contractions(const ClusterDescriptor &envs,
+                                 const DescriptorValues &struc) {
+  return {};
+}
+
+std::vector<Eigen::MatrixXd>
+Kernel ::envs_struc_grad_cached(const ClusterDescriptor &envs,
+                                const DescriptorValues &struc,
+                                const std::vector<Eigen::MatrixXd> &contractions,
+                                const Eigen::VectorXd &hyps) {
+  return envs_struc_grad(envs, struc, hyps);
+}
+
 std::vector<Eigen::MatrixXd>
 Kernel ::Kuf_grad(const ClusterDescriptor &envs,
                   const std::vector<Structure> &strucs, int kernel_index,
@@ -59,8 +75,12 @@ Kernel ::Kuf_grad(const ClusterDescriptor &envs,
 
 #pragma omp parallel for
   for (int i = 0; i < strucs.size(); i++) {
-    std::vector<Eigen::MatrixXd> envs_struc =
-        envs_struc_grad(envs, strucs[i].descriptors[kernel_index], hyps);
+    const DescriptorValues &struc_desc = strucs[i].descriptors[kernel_index];
+    std::vector<Eigen::MatrixXd> envs_struc;
+    if (struc_desc.compressed())
+      envs_struc = envs_struc_grad(envs, struc_desc.expand_force_dervs(), hyps);
+    else
+      envs_struc = envs_struc_grad(envs, struc_desc, hyps);
     int n_atoms = strucs[i].noa;
 
     for (int j = 0; j < n_hyps + 1; j++) {
@@ -25,10 +25,18 @@ public:
                                     const ClusterDescriptor &envs2,
                                     const Eigen::VectorXd &hyps) = 0;
 
+  // Diagonal of envs_envs(envs, envs, hyps).
+  virtual Eigen::VectorXd self_kernel_envs(const ClusterDescriptor &envs,
+                                           const Eigen::VectorXd &hyps) = 0;
+
   virtual std::vector<Eigen::MatrixXd>
   envs_envs_grad(const ClusterDescriptor &envs1, const ClusterDescriptor &envs2,
                  const Eigen::VectorXd &hyps) = 0;
 
+  // True if the kernel between environments of different types is zero, so
+  // that Kuu is block diagonal by type. False by default.
+  virtual bool type_diagonal();
+
   virtual Eigen::MatrixXd envs_struc(const ClusterDescriptor &envs,
                                      const DescriptorValues &struc,
                                      const Eigen::VectorXd &hyps) = 0;
@@ -37,6 +45,21 @@ public:
   envs_struc_grad(const ClusterDescriptor &envs, const DescriptorValues &struc,
                   const Eigen::VectorXd &hyps) = 0;
 
+  // Hyperparameter-independent contractions of the sparse descriptors with
+  // a structure (e.g. descriptor dot products). Kernels that return a
+  // nonempty list can evaluate envs_struc_grad for new hyperparameters from
+  // cached contractions with envs_struc_grad_cached. By default no
+  // contractions are cached.
+  virtual std::vector<Eigen::MatrixXd>
+  envs_struc_contractions(const ClusterDescriptor &envs,
+                          const DescriptorValues &struc);
+
+  virtual std::vector<Eigen::MatrixXd>
+  envs_struc_grad_cached(const ClusterDescriptor &envs,
+                         const DescriptorValues &struc,
+                         const std::vector<Eigen::MatrixXd> &contractions,
+                         const Eigen::VectorXd &hyps);
+
   virtual Eigen::VectorXd self_kernel_struc(const DescriptorValues &struc,
                                             const Eigen::VectorXd &hyps) = 0;
 
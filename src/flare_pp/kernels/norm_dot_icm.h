@@ -14,6 +14,9 @@ public:
   int no_types, n_icm_coeffs;
   Eigen::MatrixXd icm_coeffs;
 
+  /** Entry limit of the force/force blocks formed by struc_struc. */
+  long max_block_entries = 1 << 24;
+
   NormalizedDotProduct_ICM();
 
   NormalizedDotProduct_ICM(double sigma, double power,
@@ -23,6 +26,9 @@ public:
                             const ClusterDescriptor &envs2,
                             const Eigen::VectorXd &hyps);
 
+  Eigen::VectorXd self_kernel_envs(const ClusterDescriptor &envs,
+                                   const Eigen::VectorXd &hyps);
+
   std::vector<Eigen::MatrixXd> envs_envs_grad(const ClusterDescriptor &envs1,
                                               const ClusterDescriptor &envs2,
                                               const Eigen::VectorXd &hyps);
@@ -35,6 +41,16 @@ public:
                                                const DescriptorValues &struc,
                                                const Eigen::VectorXd &hyps);
 
+  std::vector<Eigen::MatrixXd>
+  envs_struc_contractions(const ClusterDescriptor &envs,
+                          const DescriptorValues &struc);
+
+  std::vector<Eigen::MatrixXd>
+  envs_struc_grad_cached(const ClusterDescriptor &envs,
+                         const DescriptorValues &struc,
+                         const std::vector<Eigen::MatrixXd> &contractions,
+                         const Eigen::VectorXd &hyps);
+
   Eigen::VectorXd self_kernel_struc(const DescriptorValues &struc,
                                     const Eigen::VectorXd &hyps);
 
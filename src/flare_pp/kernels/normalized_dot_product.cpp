@@ -2,8 +2,10 @@
 #include "descriptor.h"
 #include "sparse_gp.h"
 #include "structure.h"
+#include <Eigen/Sparse>
 #undef NDEBUG
 #include <assert.h>
+#include <algorithm>
 #include <cmath>
 #include <fstream> // File operations
 #include <iomanip> // setprecision
@@ -87,6 +89,35 @@ Eigen::MatrixXd NormalizedDotProduct ::envs_envs(const ClusterDescriptor &envs1,
   return kern_mat;
 }
 
+Eigen::VectorXd
+NormalizedDotProduct ::self_kernel_envs(const ClusterDescriptor &envs,
+                                        const Eigen::VectorXd &hyps) {
+
+  double sig_sq = hyps(0) * hyps(0);
+  double empty_thresh = 1e-8;
+
+  Eigen::VectorXd kernel_vector = Eigen::VectorXd::Zero(envs.n_clusters);
+  for (int s = 0; s < envs.n_types; s++) {
+    int n_clusters = envs.n_clusters_by_type[s];
+    int c_clusters = envs.cumulative_type_count[s];
+
+#pragma omp parallel for
+    for (int i = 0; i < n_clusters; i++) {
+      double norm_i = envs.descriptor_norms[s](i);
+
+      // Continue if environment i has no neighbors.
+      if (norm_i < empty_thresh)
+        continue;
+
+      double norm_dot =
+          envs.descriptors[s].row(i).squaredNorm() / (norm_i * norm_i);
+      kernel_vector(c_clusters + i) = sig_sq * pow(norm_dot, power);
+    }
+  }
+
+  return kernel_vector;
+}
+
 std::vector<Eigen::MatrixXd>
 NormalizedDotProduct ::envs_envs_grad(const ClusterDescriptor &envs1,
                                       const ClusterDescriptor &envs2,
@@ -100,6 +131,8 @@ NormalizedDotProduct ::envs_envs_grad(const ClusterDescriptor &envs1,
   return grad_mats;
 }
 
+bool NormalizedDotProduct ::type_diagonal() { return true; }
+
 std::vector<Eigen::MatrixXd>
 NormalizedDotProduct ::envs_struc_grad(const ClusterDescriptor &envs,
                                        const DescriptorValues &struc,
@@ -113,6 +146,47 @@ NormalizedDotProduct ::envs_struc_grad(const ClusterDescriptor &envs,
   return grad_mats;
 }
 
+Eigen::SparseMatrix<double>
+force_stress_scatter(const DescriptorValues &struc, int s) {
+  int n_struc = struc.n_clusters_by_type[s];
+  int n_rows = 3 * struc.n_neighbors_by_type[s];
+  int n_cols = 3 * struc.n_atoms + 6;
+  double vol_inv = 1 / struc.volume;
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(n_rows * 4);
+  for (int j = 0; j < n_struc; j++) {
+    int n_neigh = struc.neighbor_counts[s](j);
+    int c_neigh = struc.cumulative_neighbor_counts[s](j);
+    int atom_index = struc.atom_indices[s](j);
+
+    for (int k = 0; k < n_neigh; k++) {
+      int ind = c_neigh + k;
+      int neighbor_index = struc.neighbor_indices[s](ind);
+      int stress_counter = 0;
+      for (int comp = 0; comp < 3; comp++) {
+        int row = 3 * ind + comp;
+        triplets.push_back(
+            Eigen::Triplet<double>(row, 3 * neighbor_index + comp, -1));
+        triplets.push_back(
+            Eigen::Triplet<double>(row, 3 * atom_index + comp, 1));
+        for (int comp2 = comp; comp2 < 3; comp2++) {
+          double coord = struc.neighbor_coordinates[s](ind, comp2);
+          triplets.push_back(Eigen::Triplet<double>(
+              row, 3 * struc.n_atoms + stress_counter, -coord * vol_inv));
+          stress_counter++;
+        }
+      }
+    }
+  }
+
+  // Duplicate entries, e.g. from periodic images of the central atom, are
+  // summed.
+  Eigen::SparseMatrix<double> scatter(n_rows, n_cols);
+  scatter.setFromTriplets(triplets.begin(), triplets.end());
+  return scatter;
+}
+
 Eigen::MatrixXd NormalizedDotProduct ::envs_struc(const ClusterDescriptor &envs,
                                                   const DescriptorValues &struc,
                                                   const Eigen::VectorXd &hyps) {
@@ -130,80 +204,79 @@ Eigen::MatrixXd NormalizedDotProduct ::envs_struc(const ClusterDescriptor &envs,
   int n_descriptors_2 = struc.n_descriptors;
   assert(n_descriptors_1 == n_descriptors_2);
 
+  int n_cols = 3 * struc.n_atoms + 6;
   Eigen::MatrixXd kern_mat =
-      Eigen::MatrixXd::Zero(envs.n_clusters, 1 + struc.n_atoms * 3 + 6);
+      Eigen::MatrixXd::Zero(envs.n_clusters, 1 + n_cols);
   int n_types = envs.n_types;
-  double vol_inv = 1 / struc.volume;
   double empty_thresh = 1e-8;
 
   for (int s = 0; s < n_types; s++) {
+    int n_sparse = envs.n_clusters_by_type[s];
+    int n_struc = struc.n_clusters_by_type[s];
+    int c_sparse = envs.cumulative_type_count[s];
+    if (n_sparse == 0 || n_struc == 0)
+      continue;
+
     // Compute dot products. (Should be done in parallel with MKL.)
     Eigen::MatrixXd dot_vals =
         envs.descriptors[s] * struc.descriptors[s].transpose();
     Eigen::MatrixXd force_dot =
         envs.descriptors[s] * struc.descriptor_force_dervs[s].transpose();
 
-    Eigen::VectorXd struc_force_dot = struc.descriptor_force_dots[s];
-
-    // Compute kernels. Can parallelize over environments.
-    int n_sparse = envs.n_clusters_by_type[s];
-    int n_struc = struc.n_clusters_by_type[s];
-    int c_sparse = envs.cumulative_type_count[s];
-
-#pragma omp parallel for
-    for (int i = 0; i < n_sparse; i++) {
-      double norm_i = envs.descriptor_norms[s](i);
-
-      // Continue if sparse environment i has no neighbors.
-      if (norm_i < empty_thresh)
-        continue;
-      int sparse_index = c_sparse + i;
-
-      for (int j = 0; j < n_struc; j++) {
-        double norm_j = struc.descriptor_norms[s](j);
-        double norm_ij = norm_i * norm_j;
-        double norm_ij3 = norm_ij * norm_j * norm_j;
+    const Eigen::VectorXd &struc_force_dot = struc.descriptor_force_dots[s];
+    const Eigen::VectorXd &norms_i = envs.descriptor_norms[s];
+    const Eigen::VectorXd &norms_j = struc.descriptor_norms[s];
+
+    // Energy kernels, and the weights of the force dot products and of the
+    // structure's own descriptor force dots for each (environment, atom)
+    // pair. The force dot products are weighted in place. Parallel over
+    // atoms.
+    Eigen::MatrixXd energy_kern = Eigen::MatrixXd::Zero(n_sparse, n_struc);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int j = 0; j < n_struc; j++) {
+      double norm_j = norms_j(j);
+      int n_rows = 3 * struc.neighbor_counts[s](j);
+      int row_start = 3 * struc.cumulative_neighbor_counts[s](j);
+      Eigen::VectorXd force_weight = Eigen::VectorXd::Zero(n_sparse);
+      Eigen::VectorXd self_weight = Eigen::VectorXd::Zero(n_sparse);
+
+      // Atoms and sparse environments with no neighbors contribute nothing.
+      if (norm_j >= empty_thresh) {
+        for (int i = 0; i < n_sparse; i++) {
+          double norm_i = norms_i(i);
+          if (norm_i < empty_thresh)
+            continue;
+          double norm_ij = norm_i * norm_j;
+          double norm_dot = dot_vals(i, j) / norm_ij;
+          double pow_dot = pow(norm_dot, power - 1);
+          energy_kern(i, j) = sig_sq * pow_dot * norm_dot;
+          force_weight(i) = sig_sq * power * pow_dot / norm_ij;
+          self_weight(i) =
+              force_weight(i) * dot_vals(i, j) / (norm_j * norm_j);
+        }
+      }
 
-        // Continue if atom j has no neighbors.
-        if (norm_j < empty_thresh)
-          continue;
+      force_dot.middleCols(row_start, n_rows) =
+          force_dot.middleCols(row_start, n_rows).array().colwise() *
+              force_weight.array() -
+          (self_weight * struc_force_dot.segment(row_start, n_rows).transpose())
+              .array();
+    }
 
-        // Energy kernel.
-        double norm_dot = dot_vals(i, j) / norm_ij;
-        double dval = power * pow(norm_dot, power - 1);
-        kern_mat(sparse_index, 0) += sig_sq * pow(norm_dot, power);
+    kern_mat.block(c_sparse, 0, n_sparse, 1) = energy_kern.rowwise().sum();
 
-        // Force kernel.
-        int n_neigh = struc.neighbor_counts[s](j);
-        int c_neigh = struc.cumulative_neighbor_counts[s](j);
-        int atom_index = struc.atom_indices[s](j);
-
-        for (int k = 0; k < n_neigh; k++) {
-          int neighbor_index = struc.neighbor_indices[s](c_neigh + k);
-          int stress_counter = 0;
-
-          for (int comp = 0; comp < 3; comp++) {
-            int ind = c_neigh + k;
-            int force_index = 3 * ind + comp;
-            double f1 = force_dot(i, force_index) / norm_ij;
-            double f2 =
-                dot_vals(i, j) * struc_force_dot(force_index) / norm_ij3;
-            double f3 = f1 - f2;
-            double force_kern_val = sig_sq * dval * f3;
-
-            kern_mat(sparse_index, 1 + 3 * neighbor_index + comp) -=
-                force_kern_val;
-            kern_mat(sparse_index, 1 + 3 * atom_index + comp) += force_kern_val;
-
-            for (int comp2 = comp; comp2 < 3; comp2++) {
-              double coord = struc.neighbor_coordinates[s](ind, comp2);
-              kern_mat(sparse_index, 1 + 3 * struc.n_atoms + stress_counter) -=
-                  force_kern_val * coord * vol_inv;
-              stress_counter++;
-            }
-          }
-        }
-      }
+    // Scatter the neighbor rows onto forces and stresses, in parallel over
+    // blocks of sparse environments.
+    Eigen::SparseMatrix<double> scatter = force_stress_scatter(struc, s);
+    int block_size = 32;
+    int n_blocks = (n_sparse + block_size - 1) / block_size;
+#pragma omp parallel for
+    for (int b = 0; b < n_blocks; b++) {
+      int start = b * block_size;
+      int size = std::min(block_size, n_sparse - start);
+      kern_mat.block(c_sparse + start, 1, size, n_cols) =
+          force_dot.middleRows(start, size) * scatter;
     }
   }
 
@@ -226,7 +299,6 @@ NormalizedDotProduct ::struc_struc(const DescriptorValues &struc1,
   // Check types.
   int n_types_1 = struc1.n_types;
   int n_types_2 = struc2.n_types;
-  bool type_check = (n_types_1 == n_types_2);
   assert(n_types_1 == n_types_2);
 
   // Check descriptor size.
@@ -234,214 +306,219 @@ NormalizedDotProduct ::struc_struc(const DescriptorValues &struc1,
   int n_descriptors_2 = struc2.n_descriptors;
   assert(n_descriptors_1 == n_descriptors_2);
 
-  double vol_inv_1 = 1 / struc1.volume;
-  double vol_inv_2 = 1 / struc2.volume;
+  for (int s = 0; s < n_types_1; s++) {
+    normalized_dot_struc_struc(kernel_matrix, struc1, s, struc2, s, sig_sq,
+                               power, true, max_block_entries);
+  }
 
-  double empty_thresh = 1e-8;
-  std::vector<int> stress_inds{0, 3, 5};
+  return kernel_matrix;
+}
 
-  for (int s = 0; s < n_types_1; s++) {
-    // Compute dot products.
-    Eigen::MatrixXd dot_vals =
-        struc1.descriptors[s] * struc2.descriptors[s].transpose();
-    Eigen::MatrixXd force_dot_1 =
-        struc1.descriptor_force_dervs[s] * struc2.descriptors[s].transpose();
-    Eigen::MatrixXd force_dot_2 =
-        struc2.descriptor_force_dervs[s] * struc1.descriptors[s].transpose();
-    Eigen::MatrixXd force_force = struc1.descriptor_force_dervs[s] *
-                                  struc2.descriptor_force_dervs[s].transpose();
+void normalized_dot_struc_struc(Eigen::MatrixXd &kernel_matrix,
+                                const DescriptorValues &struc1, int s1,
+                                const DescriptorValues &struc2, int s2,
+                                double sig_sq, double power,
+                                bool check_divergence,
+                                long max_block_entries) {
+
+  int n_struc1 = struc1.n_clusters_by_type[s1];
+  int n_struc2 = struc2.n_clusters_by_type[s2];
+  if (n_struc1 == 0 || n_struc2 == 0)
+    return;
+
+  int n_rows_1 = 3 * struc1.n_neighbors_by_type[s1];
+  int n_rows_2 = 3 * struc2.n_neighbors_by_type[s2];
+  int n_cols_1 = 3 * struc1.n_atoms + 6;
+  int n_cols_2 = 3 * struc2.n_atoms + 6;
+  double empty_thresh = 1e-8;
 
-    Eigen::VectorXd struc_force_dot_1 = struc1.descriptor_force_dots[s];
-    Eigen::VectorXd struc_force_dot_2 = struc2.descriptor_force_dots[s];
+  const Eigen::MatrixXd &force_dervs_1 = struc1.descriptor_force_dervs[s1];
+  const Eigen::MatrixXd &force_dervs_2 = struc2.descriptor_force_dervs[s2];
+  const Eigen::VectorXd &struc_force_dot_1 = struc1.descriptor_force_dots[s1];
+  const Eigen::VectorXd &struc_force_dot_2 = struc2.descriptor_force_dots[s2];
+  const Eigen::VectorXd &norms_1 = struc1.descriptor_norms[s1];
+  const Eigen::VectorXd &norms_2 = struc2.descriptor_norms[s2];
+
+  // Compute dot products.
+  Eigen::MatrixXd dot_vals =
+      struc1.descriptors[s1] * struc2.descriptors[s2].transpose();
+  Eigen::MatrixXd force_dot_1 =
+      force_dervs_1 * struc2.descriptors[s2].transpose();
+  Eigen::MatrixXd force_dot_2 =
+      force_dervs_2 * struc1.descriptors[s1].transpose();
+
+  // Energy kernels and the first and second derivatives of the power
+  // function for each pair of atoms. Pairs involving an atom with no
+  // neighbors are left at zero.
+  Eigen::VectorXd inv_norms_1 = Eigen::VectorXd::Zero(n_struc1);
+  Eigen::VectorXd inv_norms_2 = Eigen::VectorXd::Zero(n_struc2);
+  for (int i = 0; i < n_struc1; i++)
+    if (norms_1(i) >= empty_thresh)
+      inv_norms_1(i) = 1 / norms_1(i);
+  for (int j = 0; j < n_struc2; j++)
+    if (norms_2(j) >= empty_thresh)
+      inv_norms_2(j) = 1 / norms_2(j);
+
+  Eigen::MatrixXd energy_kern = Eigen::MatrixXd::Zero(n_struc1, n_struc2);
+  Eigen::MatrixXd c1 = Eigen::MatrixXd::Zero(n_struc1, n_struc2);
+  Eigen::MatrixXd c2 = Eigen::MatrixXd::Zero(n_struc1, n_struc2);
+  bool diverges = false;
+
+#pragma omp parallel for reduction(|| : diverges)
+  for (int i = 0; i < n_struc1; i++) {
+    if (norms_1(i) < empty_thresh)
+      continue;
+    for (int j = 0; j < n_struc2; j++) {
+      if (norms_2(j) < empty_thresh)
+        continue;
+      double norm_dot = dot_vals(i, j) / (norms_1(i) * norms_2(j));
+      if (std::abs(norm_dot) < empty_thresh && power < 2)
+        diverges = true;
+      c1(i, j) = (power - 1) * power * pow(norm_dot, power - 2);
+      c2(i, j) = power * pow(norm_dot, power - 1);
+      energy_kern(i, j) = pow(norm_dot, power);
+    }
+  }
 
-    // Compute kernels.
-    int n_struc1 = struc1.n_clusters_by_type[s];
-    int n_struc2 = struc2.n_clusters_by_type[s];
+  if (check_divergence && diverges) {
+    throw std::invalid_argument("Dot product of descriptors is 0, \
+        and the negative power function in force-force kernel diverges.");
+  }
 
-    // TODO: Parallelize.
-    for (int i = 0; i < n_struc1; i++) {
-      double norm_i = struc1.descriptor_norms[s](i);
+  kernel_matrix(0, 0) += sig_sq * energy_kern.sum();
+
+  // Energy/force and energy/stress kernels, evaluated for each neighbor row
+  // of structure 2 and then scattered onto forces and stresses.
+  Eigen::VectorXd energy_force_2 = Eigen::VectorXd::Zero(n_rows_2);
+#pragma omp parallel for schedule(dynamic)
+  for (int j = 0; j < n_struc2; j++) {
+    double norm_j = norms_2(j);
+    if (norm_j < empty_thresh)
+      continue;
+    int start = 3 * struc2.cumulative_neighbor_counts[s2](j);
+    int size = 3 * struc2.neighbor_counts[s2](j);
+    Eigen::VectorXd weights = c2.col(j).cwiseProduct(inv_norms_1) / norm_j;
+    double self_weight = weights.dot(dot_vals.col(j)) / (norm_j * norm_j);
+    energy_force_2.segment(start, size) =
+        sig_sq * (force_dot_2.middleRows(start, size) * weights -
+                  self_weight * struc_force_dot_2.segment(start, size));
+  }
 
-      // Continue if atom i has no neighbors.
-      if (norm_i < empty_thresh)
-        continue;
+  // Force/energy and stress/energy kernels.
+  Eigen::VectorXd energy_force_1 = Eigen::VectorXd::Zero(n_rows_1);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < n_struc1; i++) {
+    double norm_i = norms_1(i);
+    if (norm_i < empty_thresh)
+      continue;
+    int start = 3 * struc1.cumulative_neighbor_counts[s1](i);
+    int size = 3 * struc1.neighbor_counts[s1](i);
+    Eigen::VectorXd weights =
+        c2.row(i).transpose().cwiseProduct(inv_norms_2) / norm_i;
+    double self_weight =
+        weights.dot(dot_vals.row(i).transpose()) / (norm_i * norm_i);
+    energy_force_1.segment(start, size) =
+        sig_sq * (force_dot_1.middleRows(start, size) * weights -
+                  self_weight * struc_force_dot_1.segment(start, size));
+  }
 
+  Eigen::SparseMatrix<double, Eigen::RowMajor> scatter_1 =
+      force_stress_scatter(struc1, s1);
+  Eigen::SparseMatrix<double> scatter_2 = force_stress_scatter(struc2, s2);
+
+  kernel_matrix.block(0, 1, 1, n_cols_2) +=
+      (scatter_2.transpose() * energy_force_2).transpose();
+  kernel_matrix.block(1, 0, n_cols_1, 1) +=
+      scatter_1.transpose() * energy_force_1;
+
+  // Force/force, force/stress, stress/force, and stress/stress kernels. The
+  // force/force products are formed for blocks of atoms of structure 1 to
+  // bound memory. Within a block, the kernel of each pair of neighbor rows
+  // is computed in parallel over atoms, which write disjoint rows, and the
+  // block is then scattered onto forces and stresses with two sparse
+  // products, in parallel over columns.
+  int atom_start = 0;
+  while (atom_start < n_struc1) {
+    int row_start = 3 * struc1.cumulative_neighbor_counts[s1](atom_start);
+    int atom_end = atom_start + 1;
+    while (atom_end < n_struc1) {
+      int next_row_end =
+          3 * (struc1.cumulative_neighbor_counts[s1](atom_end) +
+               struc1.neighbor_counts[s1](atom_end));
+      if ((long)(next_row_end - row_start) * n_rows_2 > max_block_entries)
+        break;
+      atom_end++;
+    }
+    int row_end = 3 * (struc1.cumulative_neighbor_counts[s1](atom_end - 1) +
+                       struc1.neighbor_counts[s1](atom_end - 1));
+    int block_rows = row_end - row_start;
+
+    Eigen::MatrixXd force_force =
+        force_dervs_1.middleRows(row_start, block_rows) *
+        force_dervs_2.transpose();
+
+#pragma omp parallel for schedule(dynamic)
+    for (int i = atom_start; i < atom_end; i++) {
+      int start_1 = 3 * struc1.cumulative_neighbor_counts[s1](i) - row_start;
+      int size_1 = 3 * struc1.neighbor_counts[s1](i);
+      double norm_i = norms_1(i);
       double norm_i2 = norm_i * norm_i;
       double norm_i3 = norm_i2 * norm_i;
 
       for (int j = 0; j < n_struc2; j++) {
-        double norm_j = struc2.descriptor_norms[s](j);
-
-        // Continue if atom j has no neighbors.
-        if (norm_j < empty_thresh)
+        int start_2 = 3 * struc2.cumulative_neighbor_counts[s2](j);
+        int size_2 = 3 * struc2.neighbor_counts[s2](j);
+        auto kern_block =
+            force_force.block(start_1, start_2, size_1, size_2);
+
+        double norm_j = norms_2(j);
+        if (norm_i < empty_thresh || norm_j < empty_thresh) {
+          kern_block.setZero();
           continue;
-
+        }
         double norm_j2 = norm_j * norm_j;
         double norm_j3 = norm_j2 * norm_j;
         double norm_ij = norm_i * norm_j;
-
-        // Energy/energy kernel.
         double norm_dot = dot_vals(i, j) / norm_ij;
-        double c1 = (power - 1) * power * pow(norm_dot, power - 2);
-        if (abs(norm_dot) < empty_thresh && power < 2) {
-            throw std::invalid_argument( "Dot product of descriptors is 0, \
-                and the negative power function in force-force kernel diverges." );
-        }
-        double c2 = power * pow(norm_dot, power - 1);
-        kernel_matrix(0, 0) += sig_sq * pow(norm_dot, power);
-
-        int n_neigh_1 = struc1.neighbor_counts[s](i);
-        int c_neigh_1 = struc1.cumulative_neighbor_counts[s](i);
-        int c_ind_1 = struc1.atom_indices[s](i);
-
-        int n_neigh_2 = struc2.neighbor_counts[s](j);
-        int c_neigh_2 = struc2.cumulative_neighbor_counts[s](j);
-        int c_ind_2 = struc2.atom_indices[s](j);
-
-        // Energy/force and energy/stress kernels.
-        for (int k = 0; k < n_neigh_2; k++) {
-          int ind = c_neigh_2 + k;
-          int neighbor_index = struc2.neighbor_indices[s](ind);
-          int stress_counter = 0;
-
-          for (int comp = 0; comp < 3; comp++) {
-            int force_index = 3 * ind + comp;
-            double f1 = force_dot_2(force_index, i) / norm_ij;
-            double f2 = dot_vals(i, j) * struc_force_dot_2(force_index) /
-                        (norm_i * norm_j3);
-            double f3 = f1 - f2;
-            double force_kern_val = sig_sq * c2 * f3;
-
-            // Energy/force.
-            kernel_matrix(0, 1 + 3 * neighbor_index + comp) -= force_kern_val;
-            kernel_matrix(0, 1 + 3 * c_ind_2 + comp) += force_kern_val;
-
-            // Energy/stress.
-            for (int comp2 = comp; comp2 < 3; comp2++) {
-              double coord = struc2.neighbor_coordinates[s](ind, comp2);
-              kernel_matrix(0, 1 + 3 * struc2.n_atoms + stress_counter) -=
-                  force_kern_val * coord * vol_inv_2;
-              stress_counter++;
-            }
-          }
-        }
-
-        // Force/energy and stress/energy kernels.
-        for (int k = 0; k < n_neigh_1; k++) {
-          int ind = c_neigh_1 + k;
-          int neighbor_index = struc1.neighbor_indices[s](ind);
-          int stress_counter = 0;
-
-          for (int comp = 0; comp < 3; comp++) {
-            int force_index = 3 * ind + comp;
-            double f1 = force_dot_1(force_index, j) / norm_ij;
-            double f2 = dot_vals(i, j) * struc_force_dot_1(force_index) /
-                        (norm_j * norm_i3);
-            double f3 = f1 - f2;
-            double force_kern_val = sig_sq * c2 * f3;
-
-            // Force/energy.
-            kernel_matrix(1 + 3 * neighbor_index + comp, 0) -= force_kern_val;
-            kernel_matrix(1 + 3 * c_ind_1 + comp, 0) += force_kern_val;
-
-            // Stress/energy.
-            for (int comp2 = comp; comp2 < 3; comp2++) {
-              double coord = struc1.neighbor_coordinates[s](ind, comp2);
-              kernel_matrix(1 + 3 * struc1.n_atoms + stress_counter, 0) -=
-                  force_kern_val * coord * vol_inv_1;
-              stress_counter++;
-            }
-          }
-        }
-
-        // Force/force, force/stress, stress/force, and stress/stress kernels.
-        for (int k = 0; k < n_neigh_1; k++) {
-          int ind1 = c_neigh_1 + k;
-          int n_ind_1 = struc1.neighbor_indices[s](ind1);
 
-          for (int l = 0; l < n_neigh_2; l++) {
-            int ind2 = c_neigh_2 + l;
-            int n_ind_2 = struc2.neighbor_indices[s](ind2);
-
-            for (int m = 0; m < 3; m++) {
-              int f_ind_1 = 3 * ind1 + m;
-              for (int n = 0; n < 3; n++) {
-                int f_ind_2 = 3 * ind2 + n;
-                double v1 = force_dot_1(f_ind_1, j) / norm_ij -
-                            norm_dot * struc_force_dot_1(f_ind_1) / norm_i2;
-                double v2 = force_dot_2(f_ind_2, i) / norm_ij -
-                            norm_dot * struc_force_dot_2(f_ind_2) / norm_j2;
-                double v3 = force_force(f_ind_1, f_ind_2) / norm_ij;
-                double v4 = struc_force_dot_1(f_ind_1) *
-                            force_dot_2(f_ind_2, i) / (norm_i3 * norm_j);
-                double v5 = struc_force_dot_2(f_ind_2) *
-                            force_dot_1(f_ind_1, j) / (norm_i * norm_j3);
-                double v6 = struc_force_dot_1(f_ind_1) *
-                            struc_force_dot_2(f_ind_2) * norm_dot /
-                            (norm_i2 * norm_j2);
-
-                double kern_val =
-                    sig_sq * (c1 * v1 * v2 + c2 * (v3 - v4 - v5 + v6));
-
-                // Force/force.
-                kernel_matrix(1 + c_ind_1 * 3 + m, 1 + c_ind_2 * 3 + n) +=
-                    kern_val;
-                kernel_matrix(1 + c_ind_1 * 3 + m, 1 + n_ind_2 * 3 + n) -=
-                    kern_val;
-                kernel_matrix(1 + n_ind_1 * 3 + m, 1 + c_ind_2 * 3 + n) -=
-                    kern_val;
-                kernel_matrix(1 + n_ind_1 * 3 + m, 1 + n_ind_2 * 3 + n) +=
-                    kern_val;
-
-                // Stress/force.
-                int stress_ind_1 = stress_inds[m];
-                for (int p = m; p < 3; p++) {
-                  double coord = struc1.neighbor_coordinates[s](ind1, p);
-                  kernel_matrix(1 + 3 * struc1.n_atoms + stress_ind_1,
-                                1 + c_ind_2 * 3 + n) -=
-                      kern_val * coord * vol_inv_1;
-                  kernel_matrix(1 + 3 * struc1.n_atoms + stress_ind_1,
-                                1 + n_ind_2 * 3 + n) +=
-                      kern_val * coord * vol_inv_1;
-                  stress_ind_1++;
-                }
-
-                // Force/stress.
-                int stress_ind_2 = stress_inds[n];
-                for (int p = n; p < 3; p++) {
-                  double coord = struc2.neighbor_coordinates[s](ind2, p);
-                  kernel_matrix(1 + c_ind_1 * 3 + m,
-                                1 + 3 * struc2.n_atoms + stress_ind_2) -=
-                      kern_val * coord * vol_inv_2;
-                  kernel_matrix(1 + n_ind_1 * 3 + m,
-                                1 + 3 * struc2.n_atoms + stress_ind_2) +=
-                      kern_val * coord * vol_inv_2;
-                  stress_ind_2++;
-                }
-
-                // Stress/stress.
-                stress_ind_1 = stress_inds[m];
-                for (int p = m; p < 3; p++) {
-                  double coord1 = struc1.neighbor_coordinates[s](ind1, p);
-                  stress_ind_2 = stress_inds[n];
-                  for (int q = n; q < 3; q++) {
-                    double coord2 = struc2.neighbor_coordinates[s](ind2, q);
-                    kernel_matrix(1 + 3 * struc1.n_atoms + stress_ind_1,
-                                  1 + 3 * struc2.n_atoms + stress_ind_2) +=
-                        kern_val * coord1 * coord2 * vol_inv_1 * vol_inv_2;
-                    stress_ind_2++;
-                  }
-                  stress_ind_1++;
-                }
-              }
-            }
-          }
-        }
+        auto fd_1 = force_dot_1.col(j).segment(start_1 + row_start, size_1);
+        auto fd_2 = force_dot_2.col(i).segment(start_2, size_2);
+        auto sfd_1 = struc_force_dot_1.segment(start_1 + row_start, size_1);
+        auto sfd_2 = struc_force_dot_2.segment(start_2, size_2);
+
+        // kern = c1 * v1 * v2 + c2 * (v3 - v4 - v5 + v6), where v3 is the
+        // force/force dot product and the other terms are outer products.
+        Eigen::MatrixXd U(size_1, 3), V(size_2, 3);
+        U.col(0) = c1(i, j) * (fd_1 / norm_ij - norm_dot * sfd_1 / norm_i2);
+        U.col(1) = sfd_1;
+        U.col(2) = fd_1;
+        V.col(0) = fd_2 / norm_ij - norm_dot * sfd_2 / norm_j2;
+        V.col(1) = c2(i, j) * (norm_dot * sfd_2 / (norm_i2 * norm_j2) -
+                               fd_2 / (norm_i3 * norm_j));
+        V.col(2) = -c2(i, j) * sfd_2 / (norm_i * norm_j3);
+
+        kern_block =
+            sig_sq * (c2(i, j) / norm_ij * kern_block + U * V.transpose());
       }
     }
-  }
 
-  return kernel_matrix;
+    // Scatter onto the columns of structure 2, then the rows of structure 1.
+    Eigen::SparseMatrix<double> block_scatter_1 =
+        scatter_1.middleRows(row_start, block_rows).transpose();
+    int col_block = 64;
+    int n_col_blocks = (n_cols_2 + col_block - 1) / col_block;
+#pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < n_col_blocks; b++) {
+      int col_start = b * col_block;
+      int size = std::min(col_block, n_cols_2 - col_start);
+      Eigen::MatrixXd force_cols =
+          force_force * scatter_2.middleCols(col_start, size);
+      kernel_matrix.block(1, 1 + col_start, n_cols_1, size) +=
+          block_scatter_1 * force_cols;
+    }
+
+    atom_start = atom_end;
+  }
 }
 
 Eigen::VectorXd
@@ -787,6 +864,10 @@ Eigen::MatrixXd NormalizedDotProduct ::compute_varmap_coefficients(
   //mapping_coeffs = Eigen::MatrixXd::Zero(n_species * n_species, p_size * p_size); // can be reduced by symmetry
   mapping_coeffs = Eigen::MatrixXd::Zero(n_species, p_size * p_size); // can be reduced by symmetry
 
+  // The inverse is read from the mapped file of prediction-only models.
+  Eigen::Map<const Eigen::MatrixXd> Kuu_inverse =
+      gp_model.solution_matrix("Kuu_inverse");
+
   // Get alpha index.
   
   int alpha_ind = 0;
@@ -824,7 +905,7 @@ Eigen::MatrixXd NormalizedDotProduct ::compute_varmap_coefficients(
         if (pj_norm < empty_thresh)
           continue;
 
-        double Kuu_inv_ij = gp_model.Kuu_inverse(K_ind + i, K_ind + j);
+        double Kuu_inv_ij = Kuu_inverse(K_ind + i, K_ind + j);
         double Kuu_inv_ij_normed = Kuu_inv_ij / pi_norm / pj_norm;
 //        double Sigma_ij = gp_model.Sigma(K_ind + i, K_ind + j);
 //        double Sigma_ij_normed = Sigma_ij / pi_norm / pj_norm;
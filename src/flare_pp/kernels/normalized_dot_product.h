@@ -3,6 +3,7 @@
 
 #include "kernel.h"
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 #include <vector>
 
 class DescriptorValues;
@@ -12,6 +13,9 @@ class NormalizedDotProduct : public Kernel {
 public:
   double sigma, sig2, power;
 
+  /** Entry limit of the force/force blocks formed by struc_struc. */
+  long max_block_entries = 1 << 24;
+
   NormalizedDotProduct();
 
   NormalizedDotProduct(double sigma, double power);
@@ -20,10 +24,15 @@ public:
                             const ClusterDescriptor &envs2,
                             const Eigen::VectorXd &hyps);
 
+  Eigen::VectorXd self_kernel_envs(const ClusterDescriptor &envs,
+                                   const Eigen::VectorXd &hyps);
+
   std::vector<Eigen::MatrixXd> envs_envs_grad(const ClusterDescriptor &envs1,
                                               const ClusterDescriptor &envs2,
                                               const Eigen::VectorXd &hyps);
 
+  bool type_diagonal();
+
   Eigen::MatrixXd envs_struc(const ClusterDescriptor &envs,
                              const DescriptorValues &struc,
                              const Eigen::VectorXd &hyps);
@@ -71,4 +80,29 @@ public:
   nlohmann::json return_json();
 };
 
+/**
+ * Sparse operator that maps the neighbor rows of species s (ordered as in
+ * descriptor_force_dervs) onto the force and stress entries of a structure
+ * kernel. Row 3 * k + comp subtracts from the force on neighbor k, adds to
+ * the force on the central atom, and contributes the virial term to the
+ * stresses.
+ */
+Eigen::SparseMatrix<double> force_stress_scatter(const DescriptorValues &struc,
+                                                 int s);
+
+/**
+ * Add the normalized dot product kernel between the atoms of species s1 in
+ * struc1 and species s2 in struc2, scaled by sig_sq, to the structure kernel
+ * matrix. If check_divergence is true, an exception is thrown when the
+ * force/force kernel diverges. The force/force products are formed for
+ * blocks of atoms of struc1 with at most max_block_entries entries, unless a
+ * single atom exceeds the limit.
+ */
+void normalized_dot_struc_struc(Eigen::MatrixXd &kernel_matrix,
+                                const DescriptorValues &struc1, int s1,
+                                const DescriptorValues &struc2, int s2,
+                                double sig_sq, double power,
+                                bool check_divergence,
+                                long max_block_entries = 1 << 24);
+
 #endif
@@ -78,6 +78,31 @@ Eigen::MatrixXd SquaredExponential ::envs_envs(const ClusterDescriptor &envs1,
   return kern_mat;
 }
 
+Eigen::VectorXd
+SquaredExponential ::self_kernel_envs(const ClusterDescriptor &envs,
+                                      const Eigen::VectorXd &hyps) {
+
+  double sig2 = hyps(0) * hyps(0);
+  double ls2 = hyps(1) * hyps(1);
+
+  Eigen::VectorXd kernel_vector = Eigen::VectorXd::Zero(envs.n_clusters);
+  for (int s = 0; s < envs.n_types; s++) {
+    int n_clusters = envs.n_clusters_by_type[s];
+    int c_clusters = envs.cumulative_type_count[s];
+
+#pragma omp parallel for
+    for (int i = 0; i < n_clusters; i++) {
+      double norm_i = envs.descriptor_norms[s](i);
+      double cut_i = envs.cutoff_values[s](i);
+      double dot_val = envs.descriptors[s].row(i).squaredNorm();
+      double exp_arg = (2 * norm_i * norm_i - 2 * dot_val) / (2 * ls2);
+      kernel_vector(c_clusters + i) = sig2 * cut_i * cut_i * exp(-exp_arg);
+    }
+  }
+
+  return kernel_vector;
+}
+
 std::vector<Eigen::MatrixXd>
 SquaredExponential ::envs_envs_grad(const ClusterDescriptor &envs1,
                                     const ClusterDescriptor &envs2,
@@ -150,6 +175,8 @@ SquaredExponential ::envs_envs_grad(const ClusterDescriptor &envs1,
   return kernel_gradients;
 }
 
+bool SquaredExponential ::type_diagonal() { return true; }
+
 Eigen::MatrixXd SquaredExponential ::envs_struc(const ClusterDescriptor &envs,
                                                 const DescriptorValues &struc,
                                                 const Eigen::VectorXd &hyps) {
@@ -248,6 +275,31 @@ SquaredExponential ::envs_struc_grad(const ClusterDescriptor &envs,
                                      const DescriptorValues &struc,
                                      const Eigen::VectorXd &hyps) {
 
+  return envs_struc_grad_cached(envs, struc,
+                                envs_struc_contractions(envs, struc), hyps);
+}
+
+std::vector<Eigen::MatrixXd>
+SquaredExponential ::envs_struc_contractions(const ClusterDescriptor &envs,
+                                             const DescriptorValues &struc) {
+
+  // Dot products of the sparse descriptors with the structure descriptors
+  // and their force derivatives, stored by type.
+  std::vector<Eigen::MatrixXd> contractions;
+  for (int s = 0; s < envs.n_types; s++) {
+    contractions.push_back(envs.descriptors[s] *
+                           struc.descriptors[s].transpose());
+    contractions.push_back(envs.descriptors[s] *
+                           struc.descriptor_force_dervs[s].transpose());
+  }
+  return contractions;
+}
+
+std::vector<Eigen::MatrixXd> SquaredExponential ::envs_struc_grad_cached(
+    const ClusterDescriptor &envs, const DescriptorValues &struc,
+    const std::vector<Eigen::MatrixXd> &contractions,
+    const Eigen::VectorXd &hyps) {
+
   // Define hyperparameters.
   double sig_new = hyps(0);
   double sig2_new = sig_new * sig_new;
@@ -275,11 +327,9 @@ SquaredExponential ::envs_struc_grad(const ClusterDescriptor &envs,
   double vol_inv = 1 / struc.volume;
 
   for (int s = 0; s < n_types; s++) {
-    // Compute dot products.
-    Eigen::MatrixXd dot_vals =
-        envs.descriptors[s] * struc.descriptors[s].transpose();
-    Eigen::MatrixXd force_dot =
-        envs.descriptors[s] * struc.descriptor_force_dervs[s].transpose();
+    // Retrieve dot products.
+    const Eigen::MatrixXd &dot_vals = contractions[2 * s];
+    const Eigen::MatrixXd &force_dot = contractions[2 * s + 1];
 
     Eigen::VectorXd struc_force_dot = struc.descriptor_force_dots[s];
 
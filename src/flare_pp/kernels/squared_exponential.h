@@ -20,10 +20,15 @@ public:
                             const ClusterDescriptor &envs2,
                             const Eigen::VectorXd &hyps);
 
+  Eigen::VectorXd self_kernel_envs(const ClusterDescriptor &envs,
+                                   const Eigen::VectorXd &hyps);
+
   std::vector<Eigen::MatrixXd> envs_envs_grad(const ClusterDescriptor &envs1,
                                               const ClusterDescriptor &envs2,
                                               const Eigen::VectorXd &hyps);
 
+  bool type_diagonal();
+
   Eigen::MatrixXd envs_struc(const ClusterDescriptor &envs,
                              const DescriptorValues &struc,
                              const Eigen::VectorXd &hyps);
@@ -32,6 +37,16 @@ public:
                                                const DescriptorValues &struc,
                                                const Eigen::VectorXd &hyps);
 
+  std::vector<Eigen::MatrixXd>
+  envs_struc_contractions(const ClusterDescriptor &envs,
+                          const DescriptorValues &struc);
+
+  std::vector<Eigen::MatrixXd>
+  envs_struc_grad_cached(const ClusterDescriptor &envs,
+                         const DescriptorValues &struc,
+                         const std::vector<Eigen::MatrixXd> &contractions,
+                         const Eigen::VectorXd &hyps);
+
   Eigen::VectorXd self_kernel_struc(const DescriptorValues &struc,
                                     const Eigen::VectorXd &hyps);
 
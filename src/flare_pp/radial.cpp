@@ -1,4 +1,5 @@
 #include "radial.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #define Pi 3.14159265358979323846
@@ -378,6 +379,102 @@ void calculate_radial(
   }
 }
 
+RadialTable ::RadialTable() {}
+
+RadialTable ::RadialTable(
+    std::function<void(std::vector<double> &, std::vector<double> &, double,
+                       int, std::vector<double>)>
+        basis_function,
+    std::function<void(std::vector<double> &, double, double,
+                       std::vector<double>)>
+        cutoff_function,
+    double r_min, double rcut, int N, const std::vector<double> &radial_hyps,
+    const std::vector<double> &cutoff_hyps, int n_intervals) {
+
+  this->N = N;
+  this->n_intervals = n_intervals;
+  this->r_min = r_min;
+  r_max = rcut;
+  spacing = (r_max - r_min) / n_intervals;
+  inverse_spacing = 1 / spacing;
+
+  values = std::vector<double>((n_intervals + 1) * N, 0);
+  derivatives = std::vector<double>((n_intervals + 1) * N, 0);
+
+  std::vector<double> rcut_vals(2, 0);
+  std::vector<double> basis_vals(N, 0), basis_derivs(N, 0);
+  for (int k = 0; k <= n_intervals; k++) {
+    double r = r_min + k * spacing;
+    for (int attempt = 0; attempt < 2; attempt++) {
+      std::fill(basis_vals.begin(), basis_vals.end(), 0);
+      std::fill(basis_derivs.begin(), basis_derivs.end(), 0);
+      cutoff_function(rcut_vals, r, rcut, cutoff_hyps);
+      basis_function(basis_vals, basis_derivs, r, N, radial_hyps);
+
+      bool finite = true;
+      for (int n = 0; n < N; n++) {
+        values[k * N + n] = basis_vals[n] * rcut_vals[0];
+        derivatives[k * N + n] =
+            basis_derivs[n] * rcut_vals[0] + basis_vals[n] * rcut_vals[1];
+        finite = finite && std::isfinite(values[k * N + n]) &&
+                 std::isfinite(derivatives[k * N + n]);
+      }
+
+      // Some bases (e.g. bessel) are singular at the start of their support,
+      // which neighbors never reach. Sample such a node slightly inside.
+      if (finite)
+        break;
+      r += 1e-6 * spacing;
+    }
+  }
+}
+
+void RadialTable ::calculate_radial(double *comb_vals, double *comb_x,
+                                    double *comb_y, double *comb_z, double x,
+                                    double y, double z, double r) const {
+
+  if (r < r_min || r > r_max) {
+    for (int n = 0; n < N; n++) {
+      comb_vals[n] = comb_x[n] = comb_y[n] = comb_z[n] = 0;
+    }
+    return;
+  }
+
+  int k = (r - r_min) * inverse_spacing;
+  if (k >= n_intervals)
+    k = n_intervals - 1;
+  double t = (r - r_min) * inverse_spacing - k;
+  double t2 = t * t;
+  double t3 = t2 * t;
+
+  // Hermite basis functions and their derivatives with respect to r.
+  double h00 = 2 * t3 - 3 * t2 + 1;
+  double h10 = (t3 - 2 * t2 + t) * spacing;
+  double h01 = -2 * t3 + 3 * t2;
+  double h11 = (t3 - t2) * spacing;
+  double d00 = (6 * t2 - 6 * t) * inverse_spacing;
+  double d10 = 3 * t2 - 4 * t + 1;
+  double d01 = -d00;
+  double d11 = 3 * t2 - 2 * t;
+
+  const double *v0 = &values[k * N];
+  const double *v1 = v0 + N;
+  const double *m0 = &derivatives[k * N];
+  const double *m1 = m0 + N;
+
+  double xrel = x / r;
+  double yrel = y / r;
+  double zrel = z / r;
+
+  for (int n = 0; n < N; n++) {
+    comb_vals[n] = h00 * v0[n] + h10 * m0[n] + h01 * v1[n] + h11 * m1[n];
+    double derv = d00 * v0[n] + d10 * m0[n] + d01 * v1[n] + d11 * m1[n];
+    comb_x[n] = derv * xrel;
+    comb_y[n] = derv * yrel;
+    comb_z[n] = derv * zrel;
+  }
+}
+
 void set_radial_basis(const std::string &basis_name,
                       std::function <void(std::vector<double> &,
                                           std::vector<double> &,
@@ -406,3 +503,10 @@ void set_radial_basis(const std::string &basis_name,
     radial_pointer = fourier;
   }
 }
+
+double radial_basis_min(const std::string &basis_name,
+                        const std::vector<double> &radial_hyps) {
+  if (basis_name == "equispaced_gaussians")
+    return 0;
+  return radial_hyps[0];
+}
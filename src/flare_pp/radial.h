@@ -52,6 +52,12 @@ void set_radial_basis(const std::string &basis_name,
                                           std::vector<double>)>
                                           &radial_pointer);
 
+// Lower end of the support of a radial basis, where its RadialTable starts.
+// The bases are zero below radial_hyps[0], except for the Gaussian basis,
+// which has no lower bound and whose first hyperparameter is the width.
+double radial_basis_min(const std::string &basis_name,
+                        const std::vector<double> &radial_hyps);
+
 void calculate_radial(
     std::vector<double> &comb_vals, std::vector<double> &comb_x,
     std::vector<double> &comb_y, std::vector<double> &comb_z,
@@ -64,4 +70,36 @@ void calculate_radial(
     double x, double y, double z, double r, double rcut, int N,
     std::vector<double> radial_hyps, std::vector<double> cutoff_hyps);
 
+// Cubic Hermite spline of the cutoff-weighted radial basis g_n(r) f_cut(r),
+// tabulated on a uniform grid from r_min to the cutoff. The spline matches
+// the exact values and radial derivatives at the grid points, and the
+// returned derivatives are those of the spline itself, so that forces remain
+// consistent with energies. Evaluation does not allocate.
+class RadialTable {
+public:
+  int N = 0, n_intervals = 0;
+  double r_min = 0, r_max = 0, spacing = 0, inverse_spacing = 0;
+
+  // Values and radial derivatives at the grid points, stored node by node.
+  std::vector<double> values, derivatives;
+
+  RadialTable();
+
+  RadialTable(std::function<void(std::vector<double> &, std::vector<double> &,
+                                 double, int, std::vector<double>)>
+                  basis_function,
+              std::function<void(std::vector<double> &, double, double,
+                                 std::vector<double>)>
+                  cutoff_function,
+              double r_min, double rcut, int N,
+              const std::vector<double> &radial_hyps,
+              const std::vector<double> &cutoff_hyps,
+              int n_intervals = 2048);
+
+  // Equivalent to calculate_radial, writing N entries to each array.
+  void calculate_radial(double *comb_vals, double *comb_x, double *comb_y,
+                        double *comb_z, double x, double y, double z,
+                        double r) const;
+};
+
 #endif
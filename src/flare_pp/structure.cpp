@@ -1,6 +1,13 @@
 #include "structure.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream> // File operations
 #include <iostream>
+#include <stdexcept>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 Structure ::Structure() {}
 
@@ -46,10 +53,102 @@ void Structure ::compute_descriptors(){
   descriptors.clear();
   for (int i = 0; i < descriptor_calculators.size(); i++){
     descriptors.push_back(descriptor_calculators[i]->compute_struc(*this));
+    descriptors.back().index_atoms();
   }
 }
 
+#ifdef _OPENMP
+namespace {
+// Restores the maximum number of nested active OpenMP levels on scope exit.
+struct MaxActiveLevelsGuard {
+  int max_levels;
+  MaxActiveLevelsGuard() : max_levels(omp_get_max_active_levels()) {}
+  ~MaxActiveLevelsGuard() { omp_set_max_active_levels(max_levels); }
+};
+} // namespace
+#endif
+
+std::vector<Structure>
+Structure ::build_batch(const std::vector<Eigen::MatrixXd> &cells,
+                        const std::vector<std::vector<int>> &species,
+                        const std::vector<Eigen::MatrixXd> &positions,
+                        double cutoff,
+                        std::vector<Descriptor *> descriptor_calculators) {
+  int n_frames = cells.size();
+  if (species.size() != n_frames || positions.size() != n_frames)
+    throw std::invalid_argument(
+        "cells, species and positions must have one entry per frame.");
+
+  std::vector<Structure> structures(n_frames);
+
+  // An exception cannot leave an OpenMP region, so the first one thrown by a
+  // frame is stored, the remaining frames are skipped, and it is rethrown
+  // after the region.
+  std::exception_ptr error;
+  std::atomic<bool> failed(false);
+
+#ifdef _OPENMP
+  int n_threads = omp_get_max_threads();
+  bool frame_parallel = (n_threads > 1) && (n_frames >= n_threads);
+  MaxActiveLevelsGuard levels_guard;
+  if (frame_parallel)
+    omp_set_max_active_levels(1);
+#pragma omp parallel for schedule(dynamic) if (frame_parallel)
+#endif
+  for (int i = 0; i < n_frames; i++) {
+    if (failed)
+      continue;
+    try {
+      structures[i] = Structure(cells[i], species[i], positions[i], cutoff,
+                                descriptor_calculators);
+    } catch (...) {
+#pragma omp critical(build_batch_error)
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+      failed = true;
+    }
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+
+  return structures;
+}
+
+void Structure ::compress(
+    const std::vector<ClusterDescriptor> &sparse_descriptors,
+    const std::vector<ClusterDescriptor> &new_descriptors) {
+  clear_neighbor_lists();
+
+  for (int i = 0; i < descriptors.size(); i++) {
+    std::vector<const ClusterDescriptor *> envs;
+    if (i < sparse_descriptors.size())
+      envs.push_back(&sparse_descriptors[i]);
+    if (i < new_descriptors.size())
+      envs.push_back(&new_descriptors[i]);
+    descriptors[i].compress_force_dervs(envs);
+  }
+}
+
+void Structure ::clear_neighbor_lists() {
+  relative_positions.resize(0, 0);
+  structure_indices.resize(0);
+  neighbor_species.resize(0);
+}
+
 void Structure ::compute_neighbors() {
+  if (noa >= cell_list_threshold)
+    compute_neighbors_cell_list();
+  else
+    compute_neighbors_all_pairs();
+}
+
+void Structure ::compute_neighbors_all_pairs() {
+  neighbor_count = Eigen::VectorXi::Zero(noa);
+  cumulative_neighbor_count = Eigen::VectorXi::Zero(noa + 1);
+
   // Count the neighbors of each atom and compute the relative positions
   // of all candidate neighbors.
   int sweep_unit = 2 * sweep + 1;
@@ -117,6 +216,151 @@ void Structure ::compute_neighbors() {
   }
 }
 
+void Structure ::compute_neighbors_cell_list() {
+  neighbor_count = Eigen::VectorXi::Zero(noa);
+  cumulative_neighbor_count = Eigen::VectorXi::Zero(noa + 1);
+
+  // Perpendicular height of the cell along each lattice vector. A neighbor
+  // within the cutoff can be at most cutoff / height away in fractional
+  // coordinates along that axis.
+  Eigen::Vector3d a = cell.row(0), b = cell.row(1), c = cell.row(2);
+  double heights[3] = {volume / b.cross(c).norm(), volume / c.cross(a).norm(),
+                       volume / a.cross(b).norm()};
+
+  // Choose bins that are at least one cutoff wide, and the number of bins
+  // that must be searched on either side of an atom's own bin.
+  int n_bins[3], reach[3];
+  for (int k = 0; k < 3; k++) {
+    n_bins[k] = std::max(1, int(floor(heights[k] / cutoff)));
+    reach[k] = int(ceil(cutoff * n_bins[k] / heights[k]));
+  }
+  int total_bins = n_bins[0] * n_bins[1] * n_bins[2];
+
+  // Assign each atom to a bin using its fractional coordinates.
+  Eigen::MatrixXd fractional = wrapped_positions * cell.inverse();
+  std::vector<int> atom_bins(noa);
+  std::vector<int> bin_start(total_bins + 1, 0);
+  for (int i = 0; i < noa; i++) {
+    int bin_index[3];
+    for (int k = 0; k < 3; k++) {
+      int bin = int(floor(fractional(i, k) * n_bins[k]));
+      bin_index[k] = std::min(std::max(bin, 0), n_bins[k] - 1);
+    }
+    atom_bins[i] =
+        (bin_index[0] * n_bins[1] + bin_index[1]) * n_bins[2] + bin_index[2];
+    bin_start[atom_bins[i] + 1]++;
+  }
+  for (int i = 0; i < total_bins; i++) {
+    bin_start[i + 1] += bin_start[i];
+  }
+
+  // Counting sort of the atoms by bin. Atoms in each bin stay in ascending
+  // order.
+  std::vector<int> bin_atoms(noa);
+  std::vector<int> bin_fill(bin_start.begin(), bin_start.end() - 1);
+  for (int i = 0; i < noa; i++) {
+    bin_atoms[bin_fill[atom_bins[i]]++] = i;
+  }
+
+  // Candidate neighbor of a single atom: atom index, image, and the
+  // relative position (distance, x, y, z).
+  struct Candidate {
+    int index, s1, s2, s3;
+    double dist, x, y, z;
+  };
+
+  std::vector<std::vector<Candidate>> atom_neighbors(noa);
+
+#pragma omp parallel for
+  for (int i = 0; i < noa; i++) {
+    std::vector<Candidate> &candidates = atom_neighbors[i];
+    int bin_i = atom_bins[i];
+    int b0 = bin_i / (n_bins[1] * n_bins[2]);
+    int b1 = (bin_i / n_bins[2]) % n_bins[1];
+    int b2 = bin_i % n_bins[2];
+
+    for (int d0 = -reach[0]; d0 < reach[0] + 1; d0++) {
+      int n0 = b0 + d0;
+      int s1 = int(floor(double(n0) / n_bins[0]));
+      // Restrict images to the sweep, as in the all-pairs search.
+      if (abs(s1) > sweep)
+        continue;
+      int w0 = n0 - s1 * n_bins[0];
+      for (int d1 = -reach[1]; d1 < reach[1] + 1; d1++) {
+        int n1 = b1 + d1;
+        int s2 = int(floor(double(n1) / n_bins[1]));
+        if (abs(s2) > sweep)
+          continue;
+        int w1 = n1 - s2 * n_bins[1];
+        for (int d2 = -reach[2]; d2 < reach[2] + 1; d2++) {
+          int n2 = b2 + d2;
+          int s3 = int(floor(double(n2) / n_bins[2]));
+          if (abs(s3) > sweep)
+            continue;
+          int w2 = n2 - s3 * n_bins[2];
+
+          int bin_j = (w0 * n_bins[1] + w1) * n_bins[2] + w2;
+          for (int n = bin_start[bin_j]; n < bin_start[bin_j + 1]; n++) {
+            int j = bin_atoms[n];
+            // Accumulate in the same order as the all-pairs search so that
+            // relative positions agree to the last bit.
+            double im[3];
+            for (int k = 0; k < 3; k++) {
+              double diff = wrapped_positions(j, k) - wrapped_positions(i, k);
+              im[k] = diff + s1 * cell(0, k) + s2 * cell(1, k) +
+                      s3 * cell(2, k);
+            }
+            double dist = sqrt(im[0] * im[0] + im[1] * im[1] + im[2] * im[2]);
+            if ((dist < cutoff) && (dist != 0)) {
+              Candidate candidate = {j, s1, s2, s3, dist, im[0], im[1], im[2]};
+              candidates.push_back(candidate);
+            }
+          }
+        }
+      }
+    }
+
+    // Order neighbors by atom index and then by image.
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate &x, const Candidate &y) {
+                if (x.index != y.index)
+                  return x.index < y.index;
+                if (x.s1 != y.s1)
+                  return x.s1 < y.s1;
+                if (x.s2 != y.s2)
+                  return x.s2 < y.s2;
+                return x.s3 < y.s3;
+              });
+    neighbor_count(i) = candidates.size();
+  }
+
+  // Store cumulative neighbor counts.
+  for (int i = 1; i < noa + 1; i++) {
+    cumulative_neighbor_count(i) +=
+        cumulative_neighbor_count(i - 1) + neighbor_count(i - 1);
+  }
+
+  // Store relative positions.
+  n_neighbors = cumulative_neighbor_count(noa);
+  relative_positions = Eigen::MatrixXd::Zero(n_neighbors, 4);
+  structure_indices = Eigen::VectorXi::Zero(n_neighbors);
+  neighbor_species = Eigen::VectorXi::Zero(n_neighbors);
+#pragma omp parallel for
+  for (int i = 0; i < noa; i++) {
+    const std::vector<Candidate> &candidates = atom_neighbors[i];
+    int rel_index = cumulative_neighbor_count(i);
+    for (int j = 0; j < candidates.size(); j++) {
+      const Candidate &candidate = candidates[j];
+      structure_indices(rel_index + j) = candidate.index;
+      neighbor_species(rel_index + j) = species[candidate.index];
+      relative_positions(rel_index + j, 0) = candidate.dist;
+      relative_positions(rel_index + j, 1) = candidate.x;
+      relative_positions(rel_index + j, 2) = candidate.y;
+      relative_positions(rel_index + j, 3) = candidate.z;
+    }
+  }
+}
+
 Eigen::MatrixXd Structure ::wrap_positions() {
   // Convert Cartesian coordinates to relative coordinates.
   Eigen::MatrixXd relative_positions =
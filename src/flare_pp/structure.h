@@ -98,9 +98,67 @@ public:
 
   Eigen::MatrixXd wrap_positions();
   double get_single_sweep_cutoff();
+
+  /**
+   Compute the neighbor lists of the structure. Dispatches to the linked-cell
+   builder when the structure has at least cell_list_threshold atoms, and to
+   the all-pairs loop otherwise.
+   */
   void compute_neighbors();
+
+  /**
+   Reference O(N^2) neighbor search over all atom pairs and all periodic
+   images within the sweep.
+   */
+  void compute_neighbors_all_pairs();
+
+  /**
+   Linked-cell neighbor search. Atoms are binned along the lattice vectors,
+   so that each atom only visits bins within a cutoff of its own. Produces
+   the same neighbor lists, in the same order, as the all-pairs search, in
+   O(N) time and memory.
+   */
+  void compute_neighbors_cell_list();
+
+  /**
+   Number of atoms above which compute_neighbors uses the cell list.
+   */
+  static const int cell_list_threshold = 64;
+
   void compute_descriptors();
 
+  /**
+   Construct many structures with the same cutoff and descriptor calculators,
+   e.g. the frames of a trajectory. Each OpenMP thread builds whole frames,
+   and nested parallel regions in the neighbor search and descriptor
+   calculators are disabled while the batch runs. With fewer frames than
+   threads, the frames are instead built one at a time with the usual
+   parallelism over atoms. The descriptor calculators are shared by all
+   threads and must not be modified during the call. If a frame throws, the
+   remaining frames are skipped and the first exception is rethrown.
+   */
+  static std::vector<Structure>
+  build_batch(const std::vector<Eigen::MatrixXd> &cells,
+              const std::vector<std::vector<int>> &species,
+              const std::vector<Eigen::MatrixXd> &positions, double cutoff,
+              std::vector<Descriptor *> descriptor_calculators);
+
+  /**
+   Reduce the memory footprint of a structure that is only used as a
+   training label. The neighbor lists are cleared and the descriptor force
+   derivatives are compressed against the span of the structure's own
+   descriptors and the given sparse environments. The positions are kept,
+   so the full descriptors can be recomputed with compute_neighbors and
+   compute_descriptors.
+   */
+  void compress(const std::vector<ClusterDescriptor> &sparse_descriptors,
+                const std::vector<ClusterDescriptor> &new_descriptors = {});
+
+  /**
+   Clear the neighbor lists, which are only needed to compute descriptors.
+   */
+  void clear_neighbor_lists();
+
   NLOHMANN_DEFINE_TYPE_INTRUSIVE(Structure, neighbor_count,
     cutoff, cumulative_neighbor_count, structure_indices, neighbor_species,
     cell, cell_transpose, cell_transpose_inverse, cell_dot, cell_dot_inverse,
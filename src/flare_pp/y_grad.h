@@ -4,11 +4,20 @@
 #include <Eigen/Dense>
 #include <vector>
 
-// Spherical harmonics.
+// Real spherical harmonics and their gradients up to degree l, for any l.
+// The harmonics of degree l' are stored at indices l'^2 to (l' + 1)^2 - 1 in
+// order of increasing m.
 void get_Y(std::vector<double> &Y, std::vector<double> &Yx,
            std::vector<double> &Yy, std::vector<double> &Yz, const double x,
            const double y, const double z, const int l);
 
+// Spherical harmonics of a batch of vectors. Row i of Y, Yx, Yy and Yz holds
+// the harmonics of (x(i), y(i), z(i)).
+void get_Y_batch(Eigen::MatrixXd &Y, Eigen::MatrixXd &Yx, Eigen::MatrixXd &Yy,
+                 Eigen::MatrixXd &Yz, const Eigen::VectorXd &x,
+                 const Eigen::VectorXd &y, const Eigen::VectorXd &z,
+                 const int l);
+
 void get_complex_Y(Eigen::VectorXcd &Y, Eigen::VectorXcd &Yx,
                    Eigen::VectorXcd &Yy, Eigen::VectorXcd &Yz, const double x,
                    const double y, const double z, const int l);